@@ -431,6 +431,336 @@ struct FFTFallback  : public FFT::Instance
 
 FFT::EngineImpl<FFTFallback> fftFallback;
 
+//==============================================================================
+//==============================================================================
+#if JUCE_DSP_ENABLE_SIMD_FFT
+
+/*  Computes a real transform of size N as a complex transform of size N / 2. The
+    complex transforms are radix-4 Stockham passes on separate real and imaginary
+    arrays, so that the butterflies of all but the first passes run on whole
+    SIMDRegisters, without any shuffling.
+*/
+struct SIMDRealFFT  : public FFT::Instance
+{
+    // faster than the fallback, but slower than the external libraries
+    static constexpr int priority = 2;
+
+    static SIMDRealFFT* create (int order)
+    {
+        return new SIMDRealFFT (order);
+    }
+
+    SIMDRealFFT (int order)
+        : size (1 << order), halfSize (size / 2)
+    {
+        // w^p, w^2p, w^3p for p < n / 4 of each pass size n, with w = exp (-2 pi i / n)
+        for (int n = 4, log2n = 2; n <= size; n *= 2, ++log2n)
+        {
+            twiddleOffsets[log2n] = twiddles.size();
+
+            for (int p = 0; p < n / 4; ++p)
+            {
+                for (int k = 1; k <= 3; ++k)
+                {
+                    const auto phase = -2.0 * MathConstants<double>::pi * (double) (k * p) / (double) n;
+                    twiddles.push_back ((float) std::cos (phase));
+                    twiddles.push_back ((float) std::sin (phase));
+                }
+            }
+        }
+
+        // exp (-2 pi i k / N) to untangle the two halves of the real transform
+        for (int k = 0; k < halfSize; ++k)
+        {
+            const auto phase = -2.0 * MathConstants<double>::pi * (double) k / (double) size;
+            realTwiddles.push_back ((float) std::cos (phase));
+            realTwiddles.push_back ((float) std::sin (phase));
+        }
+    }
+
+    void perform (const Complex<float>* input, Complex<float>* output, bool inverse) const noexcept override
+    {
+        if (size == 1)
+        {
+            *output = *input;
+            return;
+        }
+
+        withScratch (size, [&] (float* xr, float* xi, float* yr, float* yi)
+        {
+            // the inverse transform is the conjugate of the forward transform of the conjugate
+            const float sign = inverse ? -1.0f : 1.0f;
+
+            for (int i = 0; i < size; ++i)
+            {
+                xr[i] = input[i].real();
+                xi[i] = sign * input[i].imag();
+            }
+
+            transform (size, xr, xi, yr, yi);
+
+            const float scale = inverse ? 1.0f / (float) size : 1.0f;
+
+            for (int i = 0; i < size; ++i)
+                output[i] = { xr[i] * scale, sign * xi[i] * scale };
+        });
+    }
+
+    void performRealOnlyForwardTransform (float* d, bool onlyCalculateNonNegativeFrequencies) const noexcept override
+    {
+        if (size == 1)
+            return;
+
+        withScratch (halfSize, [&] (float* xr, float* xi, float* yr, float* yi)
+        {
+            // even samples as real, odd samples as imaginary part
+            for (int k = 0; k < halfSize; ++k)
+            {
+                xr[k] = d[2 * k];
+                xi[k] = d[2 * k + 1];
+            }
+
+            transform (halfSize, xr, xi, yr, yi);
+
+            auto* out = reinterpret_cast<Complex<float>*> (d);
+            out[0] = { xr[0] + xi[0], 0.0f };
+            out[halfSize] = { xr[0] - xi[0], 0.0f };
+
+            for (int k = 1; k < halfSize; ++k)
+            {
+                const auto ar = xr[k], ai = xi[k];
+                const auto br = xr[halfSize - k], bi = xi[halfSize - k];
+
+                // even = (Z[k] + conj Z[M - k]) / 2, odd = -i (Z[k] - conj Z[M - k]) / 2
+                const auto evenR = 0.5f * (ar + br), evenI = 0.5f * (ai - bi);
+                const auto oddR  = 0.5f * (ai + bi), oddI  = -0.5f * (ar - br);
+
+                const auto wr = realTwiddles[(size_t) (2 * k)], wi = realTwiddles[(size_t) (2 * k + 1)];
+                out[k] = { evenR + wr * oddR - wi * oddI, evenI + wr * oddI + wi * oddR };
+            }
+
+            if (! onlyCalculateNonNegativeFrequencies)
+                for (int k = 1; k < halfSize; ++k)
+                    out[size - k] = std::conj (out[k]);
+        });
+    }
+
+    void performRealOnlyInverseTransform (float* d) const noexcept override
+    {
+        if (size == 1)
+            return;
+
+        withScratch (halfSize, [&] (float* xr, float* xi, float* yr, float* yi)
+        {
+            const auto* in = reinterpret_cast<const Complex<float>*> (d);
+
+            // Z[k] = even + i odd, with even = (X[k] + conj X[M - k]) / 2 and odd = (X[k] - conj X[M - k]) / 2 * exp (2 pi i k / N),
+            // stored conjugated for the inverse transform
+            for (int k = 0; k < halfSize; ++k)
+            {
+                const auto a = in[k], b = std::conj (in[halfSize - k]);
+                const auto even = 0.5f * (a + b);
+                const auto odd = 0.5f * (a - b) * Complex<float> (realTwiddles[(size_t) (2 * k)], -realTwiddles[(size_t) (2 * k + 1)]);
+                const auto z = even + Complex<float> (-odd.imag(), odd.real());
+
+                xr[k] = z.real();
+                xi[k] = -z.imag();
+            }
+
+            transform (halfSize, xr, xi, yr, yi);
+
+            const float scale = 1.0f / (float) halfSize;
+
+            for (int k = 0; k < halfSize; ++k)
+            {
+                d[2 * k]     = xr[k] * scale;
+                d[2 * k + 1] = -xi[k] * scale;
+            }
+
+            zeromem (d + size, (size_t) size * sizeof (float));
+        });
+    }
+
+private:
+    //==============================================================================
+    // calls fn with four SIMD aligned arrays of n floats
+    template <typename Fn>
+    void withScratch (int n, Fn&& fn) const noexcept
+    {
+        const size_t scratchSize = 64 + 4 * (size_t) n * sizeof (float);
+        HeapBlock<char> heapSpace;
+        char* space = nullptr;
+
+        if (scratchSize < maxFFTScratchSpaceToAlloca)
+        {
+            JUCE_BEGIN_IGNORE_WARNINGS_MSVC (6255)
+            space = static_cast<char*> (alloca (scratchSize));
+            JUCE_END_IGNORE_WARNINGS_MSVC
+        }
+        else
+        {
+            heapSpace.malloc (scratchSize);
+            space = heapSpace.getData();
+        }
+
+        auto* xr = reinterpret_cast<float*> (space + (64 - (reinterpret_cast<pointer_sized_int> (space) & 63)) % 64);
+        fn (xr, xr + n, xr + 2 * n, xr + 3 * n);
+    }
+
+    // forward complex transform of n points, the result ends up in xr and xi
+    void transform (int n, float* xr, float* xi, float* yr, float* yi) const noexcept
+    {
+        float* outR = xr;
+        float* outI = xi;
+        int s = 1;
+
+        for (; n >= 4; n /= 4, s *= 4)
+        {
+            radix4Pass (n, s, xr, xi, yr, yi);
+            std::swap (xr, yr);
+            std::swap (xi, yi);
+        }
+
+        if (n == 2)
+        {
+            radix2Pass (s, xr, xi, yr, yi);
+            std::swap (xr, yr);
+            std::swap (xi, yi);
+        }
+
+        if (xr != outR)
+        {
+            std::copy (xr, xr + s * n, outR);
+            std::copy (xi, xi + s * n, outI);
+        }
+    }
+
+    // one pass of sub-transforms of n points, repeated with a stride of s
+    void radix4Pass (int n, int s, const float* xr, const float* xi, float* yr, float* yi) const noexcept
+    {
+        const int m = n / 4;
+        const auto* w = twiddles.data() + twiddleOffsets[findHighestSetBit ((uint32) n)];
+
+       #if JUCE_USE_SIMD
+        using Vec = SIMDRegister<float>;
+
+        if (s >= (int) Vec::size())
+        {
+            for (int p = 0; p < m; ++p, w += 6)
+            {
+                const auto w1r = Vec::expand (w[0]), w1i = Vec::expand (w[1]);
+                const auto w2r = Vec::expand (w[2]), w2i = Vec::expand (w[3]);
+                const auto w3r = Vec::expand (w[4]), w3i = Vec::expand (w[5]);
+
+                const int a = s * p, o = 4 * s * p;
+
+                for (int q = 0; q < s; q += (int) Vec::size())
+                {
+                    const auto ar = Vec::fromRawArray (xr + a + q),         ai = Vec::fromRawArray (xi + a + q);
+                    const auto br = Vec::fromRawArray (xr + a + s * m + q), bi = Vec::fromRawArray (xi + a + s * m + q);
+                    const auto cr = Vec::fromRawArray (xr + a + 2 * s * m + q), ci = Vec::fromRawArray (xi + a + 2 * s * m + q);
+                    const auto dr = Vec::fromRawArray (xr + a + 3 * s * m + q), di = Vec::fromRawArray (xi + a + 3 * s * m + q);
+
+                    const auto apcR = ar + cr, apcI = ai + ci, amcR = ar - cr, amcI = ai - ci;
+                    const auto bpdR = br + dr, bpdI = bi + di, bmdR = br - dr, bmdI = bi - di;
+
+                    (apcR + bpdR).copyToRawArray (yr + o + q);
+                    (apcI + bpdI).copyToRawArray (yi + o + q);
+
+                    const auto t1r = amcR + bmdI, t1i = amcI - bmdR;
+                    (t1r * w1r - t1i * w1i).copyToRawArray (yr + o + s + q);
+                    (t1r * w1i + t1i * w1r).copyToRawArray (yi + o + s + q);
+
+                    const auto t2r = apcR - bpdR, t2i = apcI - bpdI;
+                    (t2r * w2r - t2i * w2i).copyToRawArray (yr + o + 2 * s + q);
+                    (t2r * w2i + t2i * w2r).copyToRawArray (yi + o + 2 * s + q);
+
+                    const auto t3r = amcR - bmdI, t3i = amcI + bmdR;
+                    (t3r * w3r - t3i * w3i).copyToRawArray (yr + o + 3 * s + q);
+                    (t3r * w3i + t3i * w3r).copyToRawArray (yi + o + 3 * s + q);
+                }
+            }
+
+            return;
+        }
+       #endif
+
+        for (int p = 0; p < m; ++p, w += 6)
+        {
+            const int a = s * p, o = 4 * s * p;
+
+            for (int q = 0; q < s; ++q)
+            {
+                const auto ar = xr[a + q],             ai = xi[a + q];
+                const auto br = xr[a + s * m + q],     bi = xi[a + s * m + q];
+                const auto cr = xr[a + 2 * s * m + q], ci = xi[a + 2 * s * m + q];
+                const auto dr = xr[a + 3 * s * m + q], di = xi[a + 3 * s * m + q];
+
+                const auto apcR = ar + cr, apcI = ai + ci, amcR = ar - cr, amcI = ai - ci;
+                const auto bpdR = br + dr, bpdI = bi + di, bmdR = br - dr, bmdI = bi - di;
+
+                yr[o + q] = apcR + bpdR;
+                yi[o + q] = apcI + bpdI;
+
+                const auto t1r = amcR + bmdI, t1i = amcI - bmdR;
+                yr[o + s + q] = t1r * w[0] - t1i * w[1];
+                yi[o + s + q] = t1r * w[1] + t1i * w[0];
+
+                const auto t2r = apcR - bpdR, t2i = apcI - bpdI;
+                yr[o + 2 * s + q] = t2r * w[2] - t2i * w[3];
+                yi[o + 2 * s + q] = t2r * w[3] + t2i * w[2];
+
+                const auto t3r = amcR - bmdI, t3i = amcI + bmdR;
+                yr[o + 3 * s + q] = t3r * w[4] - t3i * w[5];
+                yi[o + 3 * s + q] = t3r * w[5] + t3i * w[4];
+            }
+        }
+    }
+
+    // last pass of an odd power of two, all twiddles are one
+    static void radix2Pass (int s, const float* xr, const float* xi, float* yr, float* yi) noexcept
+    {
+        int q = 0;
+
+       #if JUCE_USE_SIMD
+        using Vec = SIMDRegister<float>;
+
+        if (s >= (int) Vec::size())
+        {
+            for (; q < s; q += (int) Vec::size())
+            {
+                const auto ar = Vec::fromRawArray (xr + q),     ai = Vec::fromRawArray (xi + q);
+                const auto br = Vec::fromRawArray (xr + q + s), bi = Vec::fromRawArray (xi + q + s);
+
+                (ar + br).copyToRawArray (yr + q);
+                (ai + bi).copyToRawArray (yi + q);
+                (ar - br).copyToRawArray (yr + q + s);
+                (ai - bi).copyToRawArray (yi + q + s);
+            }
+        }
+       #endif
+
+        for (; q < s; ++q)
+        {
+            yr[q]     = xr[q] + xr[q + s];
+            yi[q]     = xi[q] + xi[q + s];
+            yr[q + s] = xr[q] - xr[q + s];
+            yi[q + s] = xi[q] - xi[q + s];
+        }
+    }
+
+    //==============================================================================
+    static constexpr size_t maxFFTScratchSpaceToAlloca = 256 * 1024;
+
+    const int size, halfSize;
+    std::vector<float> twiddles, realTwiddles;
+    size_t twiddleOffsets[32] = {};
+};
+
+FFT::EngineImpl<SIMDRealFFT> simdRealFFT;
+
+#endif
+
 //==============================================================================
 //==============================================================================
 #if (JUCE_MAC || JUCE_IOS) && JUCE_USE_VDSP_FRAMEWORK
@@ -991,8 +1321,9 @@ void FFT::performFrequencyOnlyForwardTransform (float* inputOutputData, bool ign
 
     const auto limit = ignoreNegativeFreqs ? (size / 2) + 1 : size;
 
+    // std::abs would use hypot, which guards against overflows these magnitudes can't reach, at a multiple of the cost
     for (int i = 0; i < limit; ++i)
-        inputOutputData[i] = std::abs (out[i]);
+        inputOutputData[i] = std::sqrt (out[i].real() * out[i].real() + out[i].imag() * out[i].imag());
 
     zeromem (inputOutputData + limit, static_cast<size_t> (size * 2 - limit) * sizeof (float));
 }
@@ -118,6 +118,16 @@
  #define JUCE_ASSERTION_FIRFILTER 1
 #endif
 
+/** Config: JUCE_DSP_ENABLE_SIMD_FFT
+
+    If this flag is set, the FFT class uses a vectorised real-input engine
+    whenever none of the external FFT libraries is available, instead of the
+    generic fallback implementation.
+*/
+#ifndef JUCE_DSP_ENABLE_SIMD_FFT
+ #define JUCE_DSP_ENABLE_SIMD_FFT 1
+#endif
+
 /** Config: JUCE_DSP_USE_INTEL_MKL
 
     If this flag is set, then JUCE will use Intel's MKL for JUCE's FFT and
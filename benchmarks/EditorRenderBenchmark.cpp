@@ -0,0 +1,265 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#include "PluginEditor.h"
+
+#include <iostream>
+#include <map>
+
+/* Renders the editor and its expensive children into offscreen images, frame
+ by frame, the way the frame scheduler would update them while audio plays.
+
+ The processor runs on a synthetic signal between the frames (noise and two
+ sweeping sines), so the analysers, the meters and the waterfall always have
+ new data. Only the editor's update and the rendering are timed. Like a peer,
+ each frame only renders the areas repainted since the previous one, so a
+ component which didn't repaint costs nothing.
+
+ Usage: Moses_EditorBench [numFrames] [numChannels]
+ Output: component, editor width, editor height, instances, mean and 99th
+ percentile milliseconds per frame (all instances of a component together). */
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+struct EditorRenderBenchmark
+{
+    static bool frameCallback (MultiBandCompressorAudioProcessorEditor& editor) { return editor.frameCallback(); }
+};
+
+namespace
+{
+struct Timings
+{
+    int numInstances = 0;
+    std::vector<double> milliseconds;
+};
+
+double millisecondsSince (const juce::int64 startTicks)
+{
+    return 1000.0 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+/* Collects the areas the editor and its children repaint, in editor coordinates.
+ Without a peer, a repaint ends at the top level component, so the editor's
+ cached image is the only place which gets to see them. */
+class DirtyRegion : public juce::CachedComponentImage
+{
+public:
+    explicit DirtyRegion (juce::Component& c) : component (c) {}
+
+    void paint (juce::Graphics& g) override { component.paintEntireComponent (g, false); }
+    bool invalidateAll() override { return invalidate (component.getLocalBounds()); }
+
+    bool invalidate (const juce::Rectangle<int>& area) override
+    {
+        areas.add (area);
+        return false;
+    }
+
+    void releaseResources() override {}
+
+    // the areas of a component repainted since the last call, in its own coordinates
+    juce::RectangleList<int> getAreas (juce::Component& child) const
+    {
+        juce::RectangleList<int> childAreas;
+        for (const auto& area : areas)
+            childAreas.addWithoutMerging (child.getLocalArea (&component, area));
+        childAreas.clipTo (child.getLocalBounds());
+        return childAreas;
+    }
+
+    void clear() { areas.clear(); }
+
+private:
+    juce::Component& component;
+    juce::RectangleList<int> areas;
+};
+
+// renders only the dirty areas, over what the image held after the last frame
+double renderMilliseconds (juce::Component& component, juce::Image& image, const juce::RectangleList<int>& dirtyAreas)
+{
+    if (dirtyAreas.isEmpty())
+        return 0.0;
+
+    juce::Graphics g (image);
+    g.reduceClipRegion (dirtyAreas);
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    component.paintEntireComponent (g, true);
+    return millisecondsSince (start);
+}
+
+// the children worth timing on their own, by name
+void findMeasuredComponents (juce::Component& parent, std::multimap<juce::String, juce::Component*>& found)
+{
+    for (auto* child : parent.getChildren())
+    {
+        if (dynamic_cast<FilterBankVisualizer<double>*> (child) != nullptr)
+            found.insert ({ "FilterBankVisualizer", child });
+        else if (dynamic_cast<AnalyserOverlay*> (child) != nullptr)
+            found.insert ({ "AnalyserOverlay", child });
+        else if (dynamic_cast<LevelMeter*> (child) != nullptr)
+            found.insert ({ "LevelMeter", child });
+        else if (dynamic_cast<WaterfallDisplay*> (child) != nullptr)
+            found.insert ({ "WaterfallDisplay", child });
+
+        findMeasuredComponents (*child, found);
+    }
+}
+
+class SignalGenerator
+{
+public:
+    void fill (juce::AudioBuffer<float>& buffer)
+    {
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            // one sine sweeps up over five seconds, the other one down
+            sweep = std::fmod (sweep + 1.0 / (5.0 * sampleRate), 1.0);
+            const double up = 40.0 * std::pow (2.0, 9.0 * sweep);
+            const double down = 16000.0 * std::pow (2.0, -7.0 * sweep);
+            phaseUp += juce::MathConstants<double>::twoPi * up / sampleRate;
+            phaseDown += juce::MathConstants<double>::twoPi * down / sampleRate;
+
+            const float sines = float (0.3 * std::sin (phaseUp) + 0.1 * std::sin (phaseDown));
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.setSample (channel, i, sines + 0.05f * (random.nextFloat() - 0.5f));
+        }
+    }
+
+    double sampleRate = 48000.0;
+
+private:
+    juce::Random random { 42 };
+    double sweep = 0.0, phaseUp = 0.0, phaseDown = 0.0;
+};
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const int numFrames = argc > 1 ? juce::jmax (1, juce::String (argv[1]).getIntValue()) : 300;
+    const int numChannels = argc > 2 ? juce::jlimit (1, 64, juce::String (argv[2]).getIntValue()) : 2;
+    const int numWarmUpFrames = 30;
+    const double sampleRate = 48000.0;
+    const int blockSize = 256;
+    const int blocksPerFrame = juce::roundToInt (0.02 * sampleRate / blockSize); // 50 frames per second
+
+    std::unique_ptr<MultiBandCompressorAudioProcessor> processor (
+        static_cast<MultiBandCompressorAudioProcessor*> (createPluginFilter()));
+    processor->setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+    processor->prepareToPlay (sampleRate, blockSize);
+
+    std::unique_ptr<juce::AudioProcessorEditor> editor (processor->createEditor());
+    auto& multiBandEditor = static_cast<MultiBandCompressorAudioProcessorEditor&> (*editor);
+
+    // owned by the editor, repaints of invisible components go nowhere
+    auto* dirtyRegion = new DirtyRegion (*editor);
+    editor->setCachedComponentImage (dirtyRegion);
+    editor->setVisible (true);
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::MidiBuffer midi;
+    SignalGenerator generator;
+    generator.sampleRate = sampleRate;
+
+    std::cout << "component\twidth\theight\tinstances\tmean_ms\tp99_ms\n";
+
+    for (const auto size : { juce::Point<int> (1000, 600), juce::Point<int> (1600, 960) })
+    {
+        editor->setSize (size.x, size.y);
+
+        // the editor isn't on screen, so it has to be told that someone is looking
+        processor->setEditorVisible (true);
+
+        std::multimap<juce::String, juce::Component*> children;
+        findMeasuredComponents (*editor, children);
+
+        // each component renders into its own image, kept from frame to frame
+        std::map<juce::Component*, juce::Image> images;
+        images[editor.get()] = juce::Image (juce::Image::ARGB, size.x, size.y, true);
+        for (const auto& child : children)
+            images[child.second] = juce::Image (juce::Image::ARGB,
+                                                juce::jmax (1, child.second->getWidth()),
+                                                juce::jmax (1, child.second->getHeight()),
+                                                true);
+
+        dirtyRegion->clear();
+        dirtyRegion->invalidateAll();
+
+        std::map<juce::String, Timings> timings;
+        for (const auto& child : children)
+            ++timings[child.first].numInstances;
+        timings["frameCallback"].numInstances = 1;
+        timings["editor"].numInstances = 1;
+
+        for (int frame = 0; frame < numWarmUpFrames + numFrames; ++frame)
+        {
+            for (int block = 0; block < blocksPerFrame; ++block)
+            {
+                generator.fill (buffer);
+                processor->processBlock (buffer, midi);
+            }
+
+            // lets the analysis service catch up, as it would between two frames
+            juce::Thread::sleep (2);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            EditorRenderBenchmark::frameCallback (multiBandEditor);
+            const double updateTime = millisecondsSince (start);
+
+            std::map<juce::String, double> frameTimes;
+            for (const auto& child : children)
+                frameTimes[child.first] += renderMilliseconds (*child.second,
+                                                               images[child.second],
+                                                               dirtyRegion->getAreas (*child.second));
+            const double editorTime = renderMilliseconds (*editor, images[editor.get()], dirtyRegion->getAreas (*editor));
+            dirtyRegion->clear();
+
+            if (frame < numWarmUpFrames)
+                continue;
+
+            timings["frameCallback"].milliseconds.push_back (updateTime);
+            timings["editor"].milliseconds.push_back (editorTime);
+            for (const auto& time : frameTimes)
+                timings[time.first].milliseconds.push_back (time.second);
+        }
+
+        for (auto& entry : timings)
+        {
+            auto& times = entry.second.milliseconds;
+            if (times.empty())
+                continue;
+
+            std::sort (times.begin(), times.end());
+            const double mean = std::accumulate (times.begin(), times.end(), 0.0) / double (times.size());
+            const double p99 = times[size_t (0.99 * double (times.size() - 1))];
+
+            std::cout << entry.first << '\t' << size.x << '\t' << size.y << '\t' << entry.second.numInstances
+                      << '\t' << mean << '\t' << p99 << '\n';
+        }
+    }
+
+    processor->setEditorVisible (false);
+    editor.reset();
+    processor->releaseResources();
+    return 0;
+}
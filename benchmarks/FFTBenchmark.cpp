@@ -0,0 +1,180 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <iostream>
+
+/* Times the transforms the analysers use, for all the fft orders they support,
+ and checks the complete output of every transform. Built twice, as
+ Moses_FFTBench with the vectorised engine and as Moses_FFTBench_Fallback with
+ JUCE's generic one, run both to compare them: an FFT always uses the best
+ engine registered, so both are checked against the same reference instead.
+
+ Output: engine, transform, order, nanoseconds per transform, max error.
+ The forward transforms are compared to a double precision DFT over all bins,
+ the inverse ones are round trips compared to their input. */
+
+namespace
+{
+using Spectrum = std::vector<std::complex<double>>;
+
+Spectrum dft (const Spectrum& input)
+{
+    const auto size = input.size();
+    Spectrum twiddles (size), output (size);
+
+    for (size_t i = 0; i < size; ++i)
+        twiddles[i] = std::polar (1.0, -2.0 * juce::MathConstants<double>::pi * (double) i / (double) size);
+
+    // the sizes are powers of two, so the twiddle index wraps with a mask
+    for (size_t k = 0; k < size; ++k)
+        for (size_t n = 0; n < size; ++n)
+            output[k] += input[n] * twiddles[(k * n) & (size - 1)];
+
+    return output;
+}
+
+double maxError (const Spectrum& expected, const std::complex<float>* actual, size_t numBins)
+{
+    double error = 0.0;
+    for (size_t k = 0; k < numBins; ++k)
+        error = juce::jmax (error, std::abs (expected[k] - std::complex<double> (actual[k])));
+
+    return error;
+}
+
+template <typename Transform>
+double nanosecondsPerCall (Transform&& transform)
+{
+    const auto minimumDuration = juce::RelativeTime::milliseconds (200);
+
+    for (int i = 0; i < 10; ++i)
+        transform();
+
+    int numCalls = 0;
+    const auto start = juce::Time::getHighResolutionTicks();
+    auto elapsed = juce::RelativeTime();
+
+    while (elapsed < minimumDuration)
+    {
+        for (int i = 0; i < 16; ++i)
+            transform();
+
+        numCalls += 16;
+        elapsed = juce::RelativeTime (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+    }
+
+    return elapsed.inSeconds() * 1.0e9 / numCalls;
+}
+
+void printResult (const char* transform, int order, double nanoseconds, double error)
+{
+    std::cout << MOSES_FFT_ENGINE << "\t" << transform << "\t" << order << "\t" << nanoseconds << "\t" << error << "\n";
+}
+} // namespace
+
+int main()
+{
+    juce::Random random (42);
+
+    std::cout << "engine\ttransform\torder\tns_per_call\tmax_error\n";
+
+    for (int order = 8; order <= 14; ++order)
+    {
+        const auto size = (size_t) 1 << order;
+        juce::dsp::FFT fft (order);
+
+        std::vector<float> input (size);
+        for (auto& sample : input)
+            sample = random.nextFloat() * 2.0f - 1.0f;
+
+        std::vector<std::complex<float>> complexInput (size);
+        for (auto& sample : complexInput)
+            sample = { random.nextFloat() * 2.0f - 1.0f, random.nextFloat() * 2.0f - 1.0f };
+
+        const auto realSpectrum = dft (Spectrum (input.begin(), input.end()));
+        const auto complexSpectrum = dft (Spectrum (complexInput.begin(), complexInput.end()));
+
+        std::vector<float> data (2 * size);
+        auto* bins = reinterpret_cast<std::complex<float>*> (data.data());
+        std::vector<std::complex<float>> complexOutput (size), roundTrip (size);
+
+        // the analysers' transforms, timed with only the non-negative frequencies as they use them
+        auto frequencyOnly = [&]
+        {
+            std::copy (input.begin(), input.end(), data.begin());
+            fft.performFrequencyOnlyForwardTransform (data.data(), true);
+        };
+
+        frequencyOnly();
+        double frequencyOnlyError = 0.0;
+        for (size_t k = 0; k <= size / 2; ++k)
+            frequencyOnlyError = juce::jmax (frequencyOnlyError, std::abs (std::abs (realSpectrum[k]) - (double) data[k]));
+
+        printResult ("frequencyOnly", order, nanosecondsPerCall (frequencyOnly), frequencyOnlyError);
+
+        auto realOnly = [&]
+        {
+            std::copy (input.begin(), input.end(), data.begin());
+            fft.performRealOnlyForwardTransform (data.data(), true);
+        };
+
+        // checked with the negative frequencies as well
+        std::copy (input.begin(), input.end(), data.begin());
+        fft.performRealOnlyForwardTransform (data.data(), false);
+        printResult ("realOnly", order, nanosecondsPerCall (realOnly), maxError (realSpectrum, bins, size));
+
+        std::copy (input.begin(), input.end(), data.begin());
+        fft.performRealOnlyForwardTransform (data.data(), false);
+        const std::vector<float> realSpectrumData (data);
+
+        auto realOnlyInverse = [&]
+        {
+            std::copy (realSpectrumData.begin(), realSpectrumData.end(), data.begin());
+            fft.performRealOnlyInverseTransform (data.data());
+        };
+
+        realOnlyInverse();
+        double realOnlyInverseError = 0.0;
+        for (size_t i = 0; i < size; ++i)
+            realOnlyInverseError = juce::jmax (realOnlyInverseError, (double) std::abs (data[i] - input[i]));
+
+        printResult ("realOnlyInverse", order, nanosecondsPerCall (realOnlyInverse), realOnlyInverseError);
+
+        // complex transforms
+        auto complexForward = [&] { fft.perform (complexInput.data(), complexOutput.data(), false); };
+
+        complexForward();
+        printResult ("complex", order, nanosecondsPerCall (complexForward), maxError (complexSpectrum, complexOutput.data(), size));
+
+        auto complexInverse = [&] { fft.perform (complexOutput.data(), roundTrip.data(), true); };
+
+        complexForward();
+        complexInverse();
+        double complexInverseError = 0.0;
+        for (size_t i = 0; i < size; ++i)
+            complexInverseError = juce::jmax (complexInverseError, (double) std::abs (roundTrip[i] - complexInput[i]));
+
+        printResult ("complexInverse", order, nanosecondsPerCall (complexInverse), complexInverseError);
+    }
+
+    return 0;
+}
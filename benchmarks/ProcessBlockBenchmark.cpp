@@ -0,0 +1,307 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#include "PluginProcessor.h"
+
+#include <chrono>
+#include <iostream>
+
+#if JUCE_INTEL
+    #include <x86intrin.h>
+#endif
+
+/* Times processBlock() of the headless processor for every combination of
+ channel count, block size, sample rate and band pattern.
+
+ Each case gets a freshly prepared processor, white noise peaking at -12 dBFS and a
+ warm-up, so gain ramps and lazily started filter stages have settled before
+ the blocks are timed. The time between blocks (refilling the buffer) isn't
+ counted.
+
+ Usage: Moses_Bench [--seconds=0.5] [--channels=1,2,8,16,64]
+                    [--block-sizes=16,...,4096] [--sample-rates=44100,48000,96000]
+                    [--patterns=all,kill0,solo2,solo0+4]
+ Output: channels, sample rate, block size, pattern, number of timed blocks,
+ nanoseconds and cycles per sample frame (all channels), median, 99th
+ percentile and longest block in microseconds, the real-time budget of a
+ block in microseconds and heap allocations per block.
+
+ Cycles are read from the time stamp counter, so they count at its constant
+ rate instead of the core's clock; they are "nan" on other platforms.
+ Allocations are only counted where malloc can be interposed (glibc), and
+ otherwise as calls of operator new. */
+
+//==============================================================================
+namespace
+{
+std::atomic<juce::int64> numAllocations { 0 };
+thread_local bool countAllocations = false;
+
+inline void countAllocation() noexcept
+{
+    if (countAllocations)
+        numAllocations.fetch_add (1, std::memory_order_relaxed);
+}
+} // namespace
+
+#if defined(__GLIBC__)
+extern "C"
+{
+void* __libc_malloc (size_t);
+void* __libc_calloc (size_t, size_t);
+void* __libc_realloc (void*, size_t);
+
+void* malloc (size_t size)
+{
+    countAllocation();
+    return __libc_malloc (size);
+}
+
+void* calloc (size_t num, size_t size)
+{
+    countAllocation();
+    return __libc_calloc (num, size);
+}
+
+void* realloc (void* ptr, size_t size)
+{
+    countAllocation();
+    return __libc_realloc (ptr, size);
+}
+}
+#else
+void* operator new (size_t size)
+{
+    countAllocation();
+    if (auto* ptr = std::malloc (size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size) { return operator new (size); }
+void operator delete (void* ptr) noexcept { std::free (ptr); }
+void operator delete[] (void* ptr) noexcept { std::free (ptr); }
+void operator delete (void* ptr, size_t) noexcept { std::free (ptr); }
+void operator delete[] (void* ptr, size_t) noexcept { std::free (ptr); }
+#endif
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+//==============================================================================
+namespace
+{
+inline juce::uint64 readCycleCounter() noexcept
+{
+#if JUCE_INTEL
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Pattern
+{
+    juce::String name;
+    juce::StringArray soloed, killed; // parameter ids
+};
+
+Pattern parsePattern (const juce::String& name)
+{
+    Pattern pattern { name, {}, {} };
+
+    // "kill0", "solo2", "solo0+4" or "all" for neither, a bare band number repeats the previous action
+    juce::String action;
+    for (auto part : juce::StringArray::fromTokens (name, "+", ""))
+    {
+        if (part.startsWith ("kill") || part.startsWith ("solo"))
+            action = part.substring (0, 4);
+        else if (action.isEmpty() || ! part.containsOnly ("0123456789"))
+            continue;
+        else
+            part = action + part;
+
+        (action == "kill" ? pattern.killed : pattern.soloed).add (part);
+    }
+
+    return pattern;
+}
+
+template <typename Type>
+std::vector<Type> parseList (const juce::ArgumentList& args, const juce::String& option, std::vector<Type> defaults)
+{
+    if (! args.containsOption (option))
+        return defaults;
+
+    std::vector<Type> values;
+    for (auto& token : juce::StringArray::fromTokens (args.getValueForOption (option), ",", ""))
+        values.push_back (static_cast<Type> (token.getDoubleValue()));
+    return values;
+}
+
+void setParameter (MultiBandCompressorAudioProcessor& processor, const juce::String& id, const float value)
+{
+    if (auto* parameter = processor.parameters.getParameter (id))
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+struct Result
+{
+    int numBlocks = 0;
+    double nanosecondsPerSample = 0.0;
+    double cyclesPerSample = 0.0;
+    double p50 = 0.0, p99 = 0.0, max = 0.0; // microseconds per block
+    double allocationsPerBlock = 0.0;
+};
+
+Result runCase (const int numChannels,
+                const double sampleRate,
+                const int blockSize,
+                const Pattern& pattern,
+                const double secondsToTime)
+{
+    std::unique_ptr<MultiBandCompressorAudioProcessor> processor (
+        static_cast<MultiBandCompressorAudioProcessor*> (createPluginFilter()));
+
+    for (int band = 0; band < numFilterBands; ++band)
+    {
+        setParameter (*processor, "solo" + juce::String (band), pattern.soloed.contains ("solo" + juce::String (band)) ? 1.0f : 0.0f);
+        setParameter (*processor, "kill" + juce::String (band), pattern.killed.contains ("kill" + juce::String (band)) ? 1.0f : 0.0f);
+    }
+
+    processor->setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+    processor->prepareToPlay (sampleRate, blockSize);
+
+    // a second of noise, the blocks are copied from it one after another
+    const int noiseLength = juce::jmax (blockSize, int (sampleRate));
+    juce::AudioBuffer<float> noise (numChannels, noiseLength);
+    juce::Random random (1);
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < noiseLength; ++i)
+            noise.setSample (channel, i, 0.5f * (random.nextFloat() - 0.5f));
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::MidiBuffer midi;
+    int noisePosition = 0;
+
+    const int numWarmUpBlocks = juce::jmax (10, int (0.1 * sampleRate / blockSize));
+    const int numBlocks = juce::jmax (50, int (secondsToTime * sampleRate / blockSize));
+
+    std::vector<double> microseconds;
+    microseconds.reserve (size_t (numBlocks));
+    std::chrono::nanoseconds totalTime { 0 };
+    juce::uint64 totalCycles = 0;
+    juce::int64 totalAllocations = 0;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    for (int block = 0; block < numWarmUpBlocks + numBlocks; ++block)
+    {
+        if (noisePosition + blockSize > noiseLength)
+            noisePosition = 0;
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.copyFrom (channel, 0, noise, channel, noisePosition, blockSize);
+        noisePosition += blockSize;
+
+        const auto allocationsBefore = numAllocations.load();
+        countAllocations = true;
+        const auto startCycles = readCycleCounter();
+        const auto startTime = std::chrono::steady_clock::now();
+
+        processor->processBlock (buffer, midi);
+
+        const auto time = std::chrono::steady_clock::now() - startTime;
+        const auto cycles = readCycleCounter() - startCycles;
+        countAllocations = false;
+
+        if (block < numWarmUpBlocks)
+            continue;
+
+        totalTime += time;
+        totalCycles += cycles;
+        totalAllocations += numAllocations.load() - allocationsBefore;
+        microseconds.push_back (std::chrono::duration<double, std::micro> (time).count());
+    }
+
+    processor->releaseResources();
+
+    std::sort (microseconds.begin(), microseconds.end());
+    const double numSamples = double (numBlocks) * blockSize;
+
+    Result result;
+    result.numBlocks = numBlocks;
+    result.nanosecondsPerSample = double (totalTime.count()) / numSamples;
+    result.cyclesPerSample = JUCE_INTEL ? double (totalCycles) / numSamples : std::numeric_limits<double>::quiet_NaN();
+    result.p50 = microseconds[microseconds.size() / 2];
+    result.p99 = microseconds[size_t (0.99 * double (microseconds.size() - 1))];
+    result.max = microseconds.back();
+    result.allocationsPerBlock = double (totalAllocations) / numBlocks;
+    return result;
+}
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // for the message manager the processor's timers need
+
+    const juce::ArgumentList args (argc, argv);
+    const double seconds = args.containsOption ("--seconds") ? juce::jmax (0.01, args.getValueForOption ("--seconds").getDoubleValue()) : 0.5;
+    const auto channelCounts = parseList<int> (args, "--channels", { 1, 2, 8, 16, 64 });
+    const auto blockSizes = parseList<int> (args, "--block-sizes", { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 });
+    const auto sampleRates = parseList<double> (args, "--sample-rates", { 44100.0, 48000.0, 96000.0 });
+
+    std::vector<Pattern> patterns;
+    const auto patternNames = args.containsOption ("--patterns")
+                                  ? juce::StringArray::fromTokens (args.getValueForOption ("--patterns"), ",", "")
+                                  : juce::StringArray { "all", "kill0", "solo2", "solo0+4" };
+    for (auto& name : patternNames)
+        patterns.push_back (parsePattern (name));
+
+    std::cout << "channels\tsample_rate\tblock_size\tpattern\tblocks\tns_per_sample\tcycles_per_sample"
+                 "\tp50_us\tp99_us\tmax_us\tbudget_us\tallocs_per_block\n";
+
+    for (const int numChannels : channelCounts)
+    {
+        if (numChannels < 1 || numChannels > MultiBandCompressorAudioProcessor::maxNumChannels)
+            continue;
+
+        for (const double sampleRate : sampleRates)
+        {
+            for (const int blockSize : blockSizes)
+            {
+                if (blockSize < 1)
+                    continue;
+
+                for (const auto& pattern : patterns)
+                {
+                    const auto result = runCase (numChannels, sampleRate, blockSize, pattern, seconds);
+
+                    std::cout << numChannels << '\t' << sampleRate << '\t' << blockSize << '\t' << pattern.name
+                              << '\t' << result.numBlocks << '\t' << result.nanosecondsPerSample << '\t'
+                              << result.cyclesPerSample << '\t' << result.p50 << '\t' << result.p99 << '\t'
+                              << result.max << '\t' << 1.0e6 * blockSize / sampleRate << '\t'
+                              << result.allocationsPerBlock << std::endl;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -13,24 +13,58 @@
 #include <juce_dsp/juce_dsp.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 
+#include "AnalysisService.h"
+
 //==============================================================================
 /*
 */
 template<typename Type>
-class Analyser : public juce::Thread
+class Analyser : public AnalysisService::Stream
 {
 public:
-    Analyser() : juce::Thread ("Freq-Analyser")
+    enum Averaging
     {
-        averager.clear();
+        exponential,
+        peakHold
+    };
+
+    struct Settings
+    {
+        int fftOrder = 12;
+        int hopSize = 0; // 0 for half of the fft size
+        Averaging averaging = exponential;
+        float exponentialWeight = 0.25f; // weight of a new frame
+        float peakHoldDecay = 0.9f; // per frame
+        typename juce::dsp::WindowingFunction<Type>::WindowingMethod window = juce::dsp::WindowingFunction<Type>::hann;
+        bool decimatedLowBand = true; // finer resolution below sampleRate / 64
+    };
+
+    static constexpr int minFftOrder = 8;
+    static constexpr int maxFftOrder = 14;
+
+    // the low band fft runs on the signal decimated by 2^numDecimationStages
+    static constexpr int numDecimationStages = 3;
+    static constexpr int decimationFactor = 1 << numDecimationStages;
+
+    /** An analyser for one or several streams, e.g. the frequency bands, which are
+        analysed together with the same settings. */
+    explicit Analyser (int numStreamsToUse = 1) :
+        numStreams (numStreamsToUse),
+        frames (3 * numStreamsToUse, maxNumFrameBins)
+    {
+        applySettings (settings);
+        frames.clear();
     }
 
-    ~Analyser() override = default;
+    ~Analyser() override { stopAnalyser(); }
 
     void addAudioData (const juce::AudioBuffer<Type>& buffer, int startChannel, int numChannels)
     {
         if (abstractFifo.getFreeSpace() < buffer.getNumSamples())
+        {
+            ++numDroppedBlocks;
             return;
+        }
 
         int start1, block1, start2, block2;
         abstractFifo.prepareToWrite (buffer.getNumSamples(), start1, block1, start2, block2);
@@ -44,63 +78,192 @@ public:
             if (block2 > 0) audioFifo.addFrom (0, start2, buffer.getReadPointer (channel, block1), block2);
         }
         abstractFifo.finishedWrite (block1 + block2);
-        waitForData.signal();
+    }
+
+    /** Adds one channel of the buffer to each stream. */
+    void addStreamData (const juce::AudioBuffer<Type>& buffer, int numSamples)
+    {
+        if (abstractFifo.getFreeSpace() < numSamples)
+        {
+            ++numDroppedBlocks;
+            return;
+        }
+
+        int start1, block1, start2, block2;
+        abstractFifo.prepareToWrite (numSamples, start1, block1, start2, block2);
+        for (int stream = 0; stream < numStreams; ++stream)
+        {
+            if (block1 > 0) audioFifo.copyFrom (stream, start1, buffer.getReadPointer (stream), block1);
+            if (block2 > 0) audioFifo.copyFrom (stream, start2, buffer.getReadPointer (stream, block1), block2);
+        }
+        abstractFifo.finishedWrite (block1 + block2);
     }
 
     void setupAnalyser (int audioFifoSize, Type sampleRateToUse)
     {
+        stopAnalyser();
+
         sampleRate = sampleRateToUse;
-        audioFifo.setSize (1, audioFifoSize);
+
+        // has to hold at least one frame of the largest fft
+        audioFifoSize = juce::jmax (audioFifoSize, 2 << maxFftOrder);
+        audioFifo.setSize (numStreams, audioFifoSize);
         abstractFifo.setTotalSize (audioFifoSize);
+    }
+
+    void startAnalyser() { service->addStream (this); }
+    void stopAnalyser() { service->removeStream (this); }
 
-        startThread (5);
+    /** Changes the analysis, can be called from any thread but the audio thread.
+        The buffers are reallocated by the analyser thread before its next frame. */
+    void setSettings (const Settings& newSettings)
+    {
+        {
+            const juce::SpinLock::ScopedLockType lock (pendingSettingsLock);
+            pendingSettings = newSettings;
+        }
+
+        settingsChanged = true;
+        service->notify();
     }
 
-    void run() override
+    /** Number of audio blocks which didn't fit into the fifo, as the analyser thread couldn't keep up. */
+    int getNumDroppedBlocks() const noexcept { return numDroppedBlocks.load(); }
+
+    // called by the analysis service
+    bool processNextFrame() override
     {
-        while (! threadShouldExit())
+        if (settingsChanged.exchange (false))
         {
-            if (abstractFifo.getNumReady() >= fft.getSize())
-            {
-                fftBuffer.clear();
+            const juce::SpinLock::ScopedLockType lock (pendingSettingsLock);
+            applySettings (pendingSettings);
+        }
+
+        const int fftSize = fft->getSize();
 
-                int start1, block1, start2, block2;
-                abstractFifo.prepareToRead (fft.getSize(), start1, block1, start2, block2);
-                if (block1 > 0) fftBuffer.copyFrom (0, 0, audioFifo.getReadPointer (0, start1), block1);
-                if (block2 > 0) fftBuffer.copyFrom (0, block1, audioFifo.getReadPointer (0, start2), block2);
-                abstractFifo.finishedRead ((block1 + block2) / 2);
+        if (abstractFifo.getNumReady() < fftSize)
+            return false;
 
-                windowing.multiplyWithWindowingTable (fftBuffer.getWritePointer (0), size_t (fft.getSize()));
-                fft.performFrequencyOnlyForwardTransform (fftBuffer.getWritePointer (0));
+        fftBuffer.clear();
 
-                juce::ScopedLock lockedForWriting (pathCreationLock);
-                averager.addFrom (0, 0, averager.getReadPointer (averagerPtr), averager.getNumSamples(), -1.0f);
-                averager.copyFrom (averagerPtr, 0, fftBuffer.getReadPointer (0), averager.getNumSamples(), 1.0f / (averager.getNumSamples() * (averager.getNumChannels() - 1)));
-                averager.addFrom (0, 0, averager.getReadPointer (averagerPtr), averager.getNumSamples());
-                if (++averagerPtr == averager.getNumChannels()) averagerPtr = 1;
+        int start1, block1, start2, block2;
+        abstractFifo.prepareToRead (fftSize, start1, block1, start2, block2);
+        for (int stream = 0; stream < numStreams; ++stream)
+        {
+            if (block1 > 0) fftBuffer.copyFrom (stream, 0, audioFifo.getReadPointer (stream, start1), block1);
+            if (block2 > 0) fftBuffer.copyFrom (stream, block1, audioFifo.getReadPointer (stream, start2), block2);
+        }
+        abstractFifo.finishedRead (hopSize);
+
+        // the last hopSize samples of the window are the ones which are new to this frame
+        if (numLowBins > 0)
+        {
+            int numDecimated = 0;
+            for (int stream = 0; stream < numStreams; ++stream)
+                numDecimated = decimate (stream, fftBuffer.getReadPointer (stream, fftSize - hopSize), hopSize);
+
+            lowBandWritePosition = (lowBandWritePosition + numDecimated) % lowBandHistory.getNumSamples();
+        }
+
+        // the transforms of all streams back to back, while the window and the fft's tables are in cache
+        for (int stream = 0; stream < numStreams; ++stream)
+        {
+            windowing->multiplyWithWindowingTable (fftBuffer.getWritePointer (stream), size_t (fftSize));
+            fft->performFrequencyOnlyForwardTransform (fftBuffer.getWritePointer (stream), true);
+        }
 
-                newDataAvailable = true;
+        const int numBins = averager.getNumSamples();
+        for (int stream = 0; stream < numStreams; ++stream)
+        {
+            // spectrum = low band bins [0, numLowBins) followed by the full band bins from stitchBin on
+            auto* magnitudes = spectrum.getWritePointer (0);
+            if (numLowBins > 0)
+            {
+                transformLowBand (stream);
+                juce::FloatVectorOperations::copy (magnitudes, lowFftBuffer.getReadPointer (0), numLowBins);
             }
+            juce::FloatVectorOperations::copy (magnitudes + numLowBins,
+                                               fftBuffer.getReadPointer (stream, numLowBins > 0 ? stitchBin : 0),
+                                               numBins - numLowBins);
+
+            auto* average = averager.getWritePointer (stream);
+            juce::FloatVectorOperations::multiply (magnitudes, 2.0f / fftSize, numBins);
 
-            if (abstractFifo.getNumReady() < fft.getSize())
-                waitForData.wait (100);
+            if (settings.averaging == peakHold)
+            {
+                juce::FloatVectorOperations::multiply (average, settings.peakHoldDecay, numBins);
+                juce::FloatVectorOperations::max (average, average, magnitudes, numBins);
+            }
+            else
+            {
+                juce::FloatVectorOperations::multiply (average, 1.0f - settings.exponentialWeight, numBins);
+                juce::FloatVectorOperations::addWithMultiply (average, magnitudes, settings.exponentialWeight, numBins);
+            }
         }
+
+        publishFrame();
+        pushPixelHistory();
+        newDataAvailable = true;
+
+        return true;
     }
 
-    void createPath (juce::Path& p, const juce::Rectangle<float> bounds, float minFreq)
+    // message thread only, draws at most one point per pixel column
+    void createPath (juce::Path& p, const juce::Rectangle<float> bounds, float minFreq, int stream = 0)
     {
         p.clear();
-        p.preallocateSpace (8 + averager.getNumSamples() * 3);
 
-        juce::ScopedLock lockedForReading (pathCreationLock);
-        const auto* fftData = averager.getReadPointer (0);
-        const auto  factor  = bounds.getWidth() / 10.0f;
+        const int frame = acquireLatestFrame();
+        updateColumnMap (pathColumns, bounds, minFreq, frameLayouts[frame]);
+
+        const int numColumns = int (pathColumns.x.size());
+        if (numColumns == 0)
+            return;
+
+        p.preallocateSpace (8 + numColumns * 3);
+
+        auto* y = pathColumns.levels.data();
+        findColumnMaxima (pathColumns, frames.getReadPointer (frame * numStreams + stream));
+
+        // y = jmap (gainToDecibels (bin, -80), -80, 0, bottom, top), the levels are never below -80 dB
+        levelsToDecibels (y, numColumns, (bounds.getY() - bounds.getBottom()) / 80.0f, bounds.getY());
 
-        p.startNewSubPath (bounds.getX() + factor * indexToX (0, minFreq), binToY (fftData [0], bounds));
-        for (int i = 0; i < averager.getNumSamples(); ++i)
-            p.lineTo (bounds.getX() + factor * indexToX (float (i), minFreq), binToY (fftData [i], bounds));
+        p.startNewSubPath (pathColumns.x[0], y[0]);
+        for (int c = 1; c < numColumns; ++c)
+            p.lineTo (pathColumns.x[size_t (c)], y[c]);
+    }
+
+    /** Message thread only, keeps every frame of the first stream as the level in dB (down to
+        -80 dB) of each of numPixels pixels on the same frequency axis as createPath(), until
+        popPixelLevels() takes it. Unlike the published frames, none is skipped while the gui is
+        slower than the analyser, unless more than numPixelHistoryFrames pile up. A numPixels of
+        0 stops it. */
+    void setPixelHistory (const int numPixels, const float minFreq)
+    {
+        const juce::SpinLock::ScopedLockType lock (pixelHistoryLock);
+        pixelHistoryNumPixels = juce::jmax (0, numPixels);
+        pixelHistoryMinFreq = minFreq;
+        pixelHistory.setSize (numPixelHistoryFrames, juce::jmax (1, pixelHistoryNumPixels));
+        pixelHistoryFifo.reset();
+    }
+
+    /** Message thread only, copies the oldest frame kept by setPixelHistory() and returns true,
+        or returns false if there is none. Pixels without a bin of their own repeat the level of
+        the bin before them. */
+    bool popPixelLevels (float* levels, const int numPixels)
+    {
+        if (numPixels != pixelHistoryNumPixels || pixelHistoryFifo.getNumReady() < 1)
+            return false;
+
+        int start1, block1, start2, block2;
+        pixelHistoryFifo.prepareToRead (1, start1, block1, start2, block2);
+        juce::FloatVectorOperations::copy (levels, pixelHistory.getReadPointer (start1), numPixels);
+        pixelHistoryFifo.finishedRead (1);
+        return true;
     }
 
+    static constexpr int numPixelHistoryFrames = 64;
+
     bool checkForNewData()
     {
         auto available = newDataAvailable.load();
@@ -109,36 +272,365 @@ public:
     }
 
 private:
+    // triple buffer: the analyser thread fills the back frame and swaps it with the
+    // published one, the message thread swaps the published frame into the front,
+    // so neither side ever waits for the other
+    enum { frameIndexMask = 3, freshFrameFlag = 4 };
 
-    inline float indexToX (float index, float minFreq) const
+    void applySettings (const Settings& newSettings)
     {
-        const auto freq = (sampleRate * index) / fft.getSize();
-        return (freq > 0.01f) ? std::log (freq / minFreq) / std::log (2.0f) : 0.0f;
+        settings = newSettings;
+        settings.fftOrder = juce::jlimit (int (minFftOrder), int (maxFftOrder), settings.fftOrder);
+
+        const int fftSize = 1 << settings.fftOrder;
+        hopSize = settings.hopSize > 0 ? juce::jmin (settings.hopSize, fftSize) : fftSize / 2;
+
+        fft = std::make_unique<juce::dsp::FFT> (settings.fftOrder);
+        windowing = std::make_unique<juce::dsp::WindowingFunction<Type>> (size_t (fftSize), settings.window, true);
+        fftBuffer.setSize (numStreams, fftSize * 2);
+
+        stitchBin = fftSize / (2 * decimationFactor * 4);
+        numLowBins = settings.decimatedLowBand ? stitchBin * decimationFactor : 0;
+        lowFftBuffer.setSize (1, fftSize * 2);
+        lowBandHistory.setSize (numStreams, fftSize);
+        lowBandHistory.clear();
+        lowBandWritePosition = 0;
+        decimationBuffer.setSize (1, fftSize);
+        decimators.resize (size_t (numStreams * numDecimationStages));
+        for (auto& decimator : decimators)
+            decimator.reset();
+
+        const int numBins = numLowBins + fftSize / 2 - (numLowBins > 0 ? stitchBin : 0);
+        spectrum.setSize (1, numBins);
+        averager.setSize (numStreams, numBins);
+        averager.clear();
     }
 
-    inline float binToY (float bin, const juce::Rectangle<float> bounds) const
+    // feeds new samples through the halfband cascade into the low band history,
+    // returns the number of decimated samples, the write position is advanced by the caller
+    int decimate (int stream, const float* input, int numSamples)
     {
-        const float infinity = -80.0f;
-        return juce::jmap (juce::Decibels::gainToDecibels (bin, infinity),
-                           infinity, 0.0f, bounds.getBottom(), bounds.getY());
+        auto* data = decimationBuffer.getWritePointer (0);
+        juce::FloatVectorOperations::copy (data, input, numSamples);
+
+        for (int stage = 0; stage < numDecimationStages; ++stage)
+            numSamples = decimators[size_t (stream * numDecimationStages + stage)].process (data, numSamples, data);
+
+        auto* history = lowBandHistory.getWritePointer (stream);
+        const int historySize = lowBandHistory.getNumSamples();
+        for (int i = 0, position = lowBandWritePosition; i < numSamples; ++i)
+        {
+            history[position] = data[i];
+            if (++position == historySize)
+                position = 0;
+        }
+
+        return numSamples;
+    }
+
+    void transformLowBand (int stream)
+    {
+        const int fftSize = fft->getSize();
+        const int numOldest = fftSize - lowBandWritePosition;
+
+        lowFftBuffer.clear();
+        lowFftBuffer.copyFrom (0, 0, lowBandHistory, stream, lowBandWritePosition, numOldest);
+        lowFftBuffer.copyFrom (0, numOldest, lowBandHistory, stream, 0, lowBandWritePosition);
+
+        windowing->multiplyWithWindowingTable (lowFftBuffer.getWritePointer (0), size_t (fftSize));
+        fft->performFrequencyOnlyForwardTransform (lowFftBuffer.getWritePointer (0), true);
     }
 
-    juce::WaitableEvent waitForData;
-    juce::CriticalSection pathCreationLock;
+    void publishFrame()
+    {
+        for (int stream = 0; stream < numStreams; ++stream)
+            frames.copyFrom (backFrame * numStreams + stream, 0, averager, stream, 0, averager.getNumSamples());
+        frameLayouts[backFrame] = { fft->getSize(), numLowBins, sampleRate };
+        backFrame = publishedFrame.exchange (backFrame | freshFrameFlag) & frameIndexMask;
+    }
+
+    // analyser thread, the levels of the frame it just finished for the pixel history
+    void pushPixelHistory()
+    {
+        const juce::SpinLock::ScopedLockType lock (pixelHistoryLock);
+
+        const int numPixels = pixelHistoryNumPixels;
+        if (numPixels == 0 || pixelHistoryFifo.getFreeSpace() < 1)
+            return;
+
+        updateColumnMap (historyColumns, { 0.0f, 0.0f, float (numPixels), 1.0f }, pixelHistoryMinFreq,
+                         { fft->getSize(), numLowBins, sampleRate });
+
+        const int numColumns = int (historyColumns.x.size());
+        if (numColumns == 0)
+            return;
+
+        auto* columnLevels = historyColumns.levels.data();
+        findColumnMaxima (historyColumns, averager.getReadPointer (0));
+        levelsToDecibels (columnLevels, numColumns, 1.0f, 0.0f);
+
+        int start1, block1, start2, block2;
+        pixelHistoryFifo.prepareToWrite (1, start1, block1, start2, block2);
+        auto* levels = pixelHistory.getWritePointer (start1);
+        for (int pixel = 0, c = 0; pixel < numPixels; ++pixel)
+        {
+            while (c + 1 < numColumns && historyColumns.x[size_t (c + 1)] <= float (pixel) + 0.5f)
+                ++c;
+            levels[pixel] = columnLevels[c];
+        }
+        pixelHistoryFifo.finishedWrite (1);
+    }
+
+    // message thread only, returns the index of the latest complete frame
+    int acquireLatestFrame()
+    {
+        if (publishedFrame.load() & freshFrameFlag)
+            frontFrame = publishedFrame.exchange (frontFrame) & frameIndexMask;
+
+        return frontFrame;
+    }
+
+    // what the bins of a frame stand for, published with the frame
+    struct FrameLayout
+    {
+        int fftSize = 1 << 12;
+        int numLowBins = 0;
+        Type sampleRate {};
+
+        bool operator== (const FrameLayout& other) const noexcept
+        {
+            return fftSize == other.fftSize && numLowBins == other.numLowBins && sampleRate == other.sampleRate;
+        }
+    };
+
+    // bins grouped into the pixel columns they are drawn to
+    struct ColumnMap
+    {
+        juce::Rectangle<float> bounds;
+        float minFreq = 0.0f;
+        FrameLayout layout { 0, 0, {} };
+        std::vector<int> firstBin; // one entry per column, plus the end of the last one
+        std::vector<float> x;
+        std::vector<float> levels; // scratch for the column maxima
+    };
+
+    // highest bin of each column, at least minimumLevel
+    void findColumnMaxima (ColumnMap& map, const float* fftData) const
+    {
+        const int numColumns = int (map.x.size());
+        auto* levels = map.levels.data();
+
+        for (int c = 0; c < numColumns; ++c)
+            levels[c] = juce::FloatVectorOperations::findMaximum (fftData + map.firstBin[size_t (c)],
+                                                                   map.firstBin[size_t (c + 1)] - map.firstBin[size_t (c)]);
+
+        juce::FloatVectorOperations::max (levels, levels, minimumLevel, numColumns);
+    }
+
+    /* offset + scale * 20 * log10 (level) of positive, finite levels in a single pass. The
+       logarithm of the mantissa comes from the atanh series, which keeps the loop free of
+       branches and library calls, so the compiler vectorises it. Within 0.0002 dB. */
+    static void levelsToDecibels (float* levels, const int numLevels, const float scale, const float offset) noexcept
+    {
+        const float scaleLog2 = scale * 20.0f * 0.30102999566f; // 20 * log10 (2)
+
+        for (int i = 0; i < numLevels; ++i)
+        {
+            // level = 2^exponent * mantissa, mantissa in [1, 2)
+            juce::uint32 bits;
+            std::memcpy (&bits, levels + i, sizeof (bits));
+            const float exponent = float (int (bits >> 23) - 127);
+            bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+            float mantissa;
+            std::memcpy (&mantissa, &bits, sizeof (mantissa));
+
+            // log2 (m) = 2 / ln (2) * atanh (t), t = (m - 1) / (m + 1) in [0, 1/3)
+            const float t = (mantissa - 1.0f) / (mantissa + 1.0f);
+            const float t2 = t * t;
+            const float log2Mantissa = t * (2.8853900818f + t2 * (0.9617966939f + t2 * (0.5770780164f + t2 * 0.4121985831f)));
+
+            levels[i] = offset + scaleLog2 * (exponent + log2Mantissa);
+        }
+    }
+
+    // rebuilt only if the layout changed
+    void updateColumnMap (ColumnMap& map, const juce::Rectangle<float> bounds, float minFreq, const FrameLayout& layout)
+    {
+        if (bounds == map.bounds && minFreq == map.minFreq && layout == map.layout)
+            return;
+
+        map.bounds = bounds;
+        map.minFreq = minFreq;
+        map.layout = layout;
+
+        const int fftSize = layout.fftSize;
+        const int lowBins = layout.numLowBins;
+
+        // frequency of a bin of the (stitched) spectrum, in full band bins
+        const int firstFullBandBin = lowBins > 0 ? lowBins / decimationFactor : 0;
+        auto binToIndex = [&] (int bin)
+        {
+            return bin < lowBins ? float (bin) / decimationFactor : float (bin - lowBins + firstFullBandBin);
+        };
+
+        auto& columnFirstBin = map.firstBin;
+        auto& columnX = map.x;
+        columnFirstBin.clear();
+        columnX.clear();
+
+        const auto factor = bounds.getWidth() / 10.0f;
+        const int numPixels = juce::jmax (1, int (bounds.getWidth()));
+        int currentColumn = -1;
+        int numBinsInColumn = 0;
+        float xSum = 0.0f;
+
+        for (int i = 0; i < lowBins + fftSize / 2 - firstFullBandBin; ++i)
+        {
+            const auto x = factor * indexToX (binToIndex (i), minFreq, layout);
+            if (x < 0.0f || x > bounds.getWidth())
+                continue;
+
+            const int column = juce::jmin (int (x), numPixels - 1);
+            if (column != currentColumn)
+            {
+                if (currentColumn >= 0)
+                    columnX.push_back (bounds.getX() + xSum / float (numBinsInColumn));
+
+                columnFirstBin.push_back (i);
+                currentColumn = column;
+                numBinsInColumn = 0;
+                xSum = 0.0f;
+            }
+
+            xSum += x;
+            ++numBinsInColumn;
+        }
+
+        if (currentColumn >= 0)
+        {
+            columnX.push_back (bounds.getX() + xSum / float (numBinsInColumn));
+            columnFirstBin.push_back (columnFirstBin.back() + numBinsInColumn);
+        }
+
+        map.levels.resize (columnX.size());
+    }
+
+    static inline float indexToX (float index, float minFreq, const FrameLayout& layout)
+    {
+        const auto freq = (layout.sampleRate * index) / layout.fftSize;
+        return (freq > 0.01f) ? std::log (freq / minFreq) / std::log (2.0f) : 0.0f;
+    }
+
+    juce::SharedResourcePointer<AnalysisService> service;
+
+    Type sampleRate {}; // set while the analyser is stopped, the gui uses the one of each frame
+
+    const int numStreams;
+
+    // analyser thread only
+    Settings settings;
+    int hopSize = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<Type>> windowing;
+    juce::AudioBuffer<float> fftBuffer;
+    juce::AudioBuffer<float> spectrum;
+    juce::AudioBuffer<float> averager;
+
+    // low band analysis
+    struct HalfbandDecimator
+    {
+        static constexpr int numTaps = 23;
+
+        HalfbandDecimator()
+        {
+            // blackman windowed sinc with its cutoff at a quarter of the sample rate
+            const int centre = numTaps / 2;
+            float sum = 0.0f;
+            for (int n = 0; n < numTaps; ++n)
+            {
+                const int k = n - centre;
+                const float sinc = k == 0 ? 0.5f : std::sin (juce::MathConstants<float>::halfPi * k) / (juce::MathConstants<float>::pi * k);
+                const float phase = juce::MathConstants<float>::twoPi * n / (numTaps - 1);
+                coefficients[n] = sinc * (0.42f - 0.5f * std::cos (phase) + 0.08f * std::cos (2.0f * phase));
+                sum += coefficients[n];
+            }
+            juce::FloatVectorOperations::multiply (coefficients, 1.0f / sum, numTaps);
+        }
+
+        void reset()
+        {
+            juce::FloatVectorOperations::clear (delayLine, 2 * numTaps);
+            position = 0;
+            odd = false;
+        }
+
+        // returns the number of output samples, output may be the same as input
+        int process (const float* input, int numSamples, float* output)
+        {
+            int numOutputs = 0;
+            for (int i = 0; i < numSamples; ++i)
+            {
+                // the delay line is stored twice, so the taps are always contiguous
+                delayLine[position] = delayLine[position + numTaps] = input[i];
+                if (++position == numTaps)
+                    position = 0;
+
+                odd = ! odd;
+                if (odd)
+                    continue;
+
+                const float* taps = delayLine + position;
+                float sum = 0.0f;
+                for (int n = 0; n < numTaps; ++n)
+                    sum += coefficients[n] * taps[n];
+                output[numOutputs++] = sum;
+            }
+            return numOutputs;
+        }
+
+        float coefficients[numTaps];
+        float delayLine[2 * numTaps] = {};
+        int position = 0;
+        bool odd = false;
+    };
+
+    std::vector<HalfbandDecimator> decimators; // numDecimationStages for each stream
+    juce::AudioBuffer<float> decimationBuffer;
+    juce::AudioBuffer<float> lowBandHistory;
+    int lowBandWritePosition = 0;
+    juce::AudioBuffer<float> lowFftBuffer;
+    int stitchBin = 0; // first full band bin after the low band
+    int numLowBins = 0;
+
+    juce::SpinLock pendingSettingsLock;
+    Settings pendingSettings;
+    std::atomic<bool> settingsChanged { false };
 
-    Type sampleRate {};
+    // allocated for the largest fft, so changing the settings never reallocates what the gui reads
+    static constexpr int maxNumFrameBins = (1 << (maxFftOrder - 1)) + (1 << maxFftOrder) / 8;
+    juce::AudioBuffer<float> frames; // numStreams channels for each of the three frames
+    FrameLayout frameLayouts[3];
+    int backFrame = 0, frontFrame = 2;
+    std::atomic<int> publishedFrame { 1 };
 
-    juce::dsp::FFT fft                           { 12 };
-    juce::dsp::WindowingFunction<Type> windowing { size_t (fft.getSize()), juce::dsp::WindowingFunction<Type>::hann, true };
-    juce::AudioBuffer<float> fftBuffer           { 1, fft.getSize() * 2 };
+    // bin to pixel column map of createPath(), message thread only
+    static constexpr float minimumLevel = 0.0001f; // -80 dB
+    ColumnMap pathColumns;
 
-    juce::AudioBuffer<float> averager            { 5, fft.getSize() / 2 };
-    int averagerPtr = 1;
+    // every frame's pixel levels, one channel per frame, written by the analyser thread while
+    // holding the lock, which the message thread only takes to change the layout
+    juce::SpinLock pixelHistoryLock;
+    int pixelHistoryNumPixels = 0;
+    float pixelHistoryMinFreq = 20.0f;
+    juce::AudioBuffer<float> pixelHistory;
+    juce::AbstractFifo pixelHistoryFifo { numPixelHistoryFrames };
+    ColumnMap historyColumns; // analyser thread only
 
     juce::AbstractFifo abstractFifo              { 48000 };
     juce::AudioBuffer<Type> audioFifo;
 
     std::atomic<bool> newDataAvailable;
+    std::atomic<int> numDroppedBlocks { 0 };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Analyser)
 };
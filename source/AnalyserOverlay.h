@@ -0,0 +1,107 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+/* Transparent layer for frequently changing traces, like analyser spectra.
+
+ Updating a trace only repaints the area covered by its old and its new path,
+ so everything else stays untouched, and layers underneath can be cached with
+ setBufferedToImage(). */
+
+class AnalyserOverlay : public juce::Component
+{
+public:
+    AnalyserOverlay() { setInterceptsMouseClicks (false, false); }
+
+    /** Adds a trace and returns its index, traces are painted in the order they were added. */
+    int addTrace (const juce::Colour colour, const float thickness = 1.0f)
+    {
+        traces.add ({ {}, colour, thickness, {} });
+        return traces.size() - 1;
+    }
+
+    void setTraceColour (const int index, const juce::Colour colour)
+    {
+        auto& trace = traces.getReference (index);
+        if (trace.colour != colour)
+        {
+            trace.colour = colour;
+            repaint (trace.dirtyArea);
+        }
+    }
+
+    /** Calls createPath with a cleared path and repaints the area the trace has changed in.
+        Returns false, if the new path is identical to the old one. */
+    template <typename CreatePath>
+    bool updateTrace (const int index, CreatePath&& createPath)
+    {
+        auto& trace = traces.getReference (index);
+
+        scratchPath.clear();
+        createPath (scratchPath);
+        if (scratchPath == trace.path)
+            return false;
+
+        trace.path.swapWithPath (scratchPath);
+
+        const auto newArea = trace.path.getBounds()
+                                 .expanded (trace.thickness + 1.0f)
+                                 .getSmallestIntegerContainer()
+                                 .getIntersection (getLocalBounds());
+
+        repaint (trace.dirtyArea.getUnion (newArea));
+        trace.dirtyArea = newArea;
+        return true;
+    }
+
+    bool clearTrace (const int index)
+    {
+        return updateTrace (index, [] (juce::Path&) {});
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        for (auto& trace : traces)
+        {
+            if (trace.path.isEmpty() || ! g.clipRegionIntersects (trace.dirtyArea))
+                continue;
+
+            g.setColour (trace.colour);
+            g.strokePath (trace.path, juce::PathStrokeType (trace.thickness));
+        }
+    }
+
+private:
+    struct Trace
+    {
+        juce::Path path;
+        juce::Colour colour;
+        float thickness;
+        juce::Rectangle<int> dirtyArea; // area covered by the path, including its stroke
+    };
+
+    juce::Array<Trace> traces;
+    juce::Path scratchPath; // swapped with the trace paths, so updates don't allocate
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyserOverlay)
+};
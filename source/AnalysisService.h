@@ -0,0 +1,168 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// number of workers and their CPU affinity mask, set by the MOSES_ANALYSIS_* CMake variables
+#ifndef MOSES_ANALYSIS_WORKERS
+    #define MOSES_ANALYSIS_WORKERS 1
+#endif
+
+#ifndef MOSES_ANALYSIS_AFFINITY_MASK
+    #define MOSES_ANALYSIS_AFFINITY_MASK 0
+#endif
+
+/* Worker threads shared by all analysis streams of a process, use it through a
+ juce::SharedResourcePointer<AnalysisService>. The workers take turns on the
+ registered streams, so several plug-in instances don't each bring their own
+ analyser threads.
+
+ The audio thread should call notify() once per block, after it has pushed
+ data to all of its streams. */
+
+class AnalysisService
+{
+public:
+    class Stream
+    {
+    public:
+        virtual ~Stream() = default;
+
+        /** Processes at most one frame, returns false if there was nothing to do. */
+        virtual bool processNextFrame() = 0;
+
+    private:
+        friend class AnalysisService;
+        std::atomic<bool> isBeingProcessed { false };
+    };
+
+    AnalysisService() { setNumWorkers (MOSES_ANALYSIS_WORKERS, juce::uint32 (MOSES_ANALYSIS_AFFINITY_MASK)); }
+
+    ~AnalysisService() { stopWorkers(); }
+
+    void addStream (Stream* stream)
+    {
+        {
+            const juce::ScopedWriteLock lock (streamsLock);
+            streams.addIfNotAlreadyThere (stream);
+        }
+        notify();
+    }
+
+    /** Returns when no worker is processing the stream anymore. */
+    void removeStream (Stream* stream)
+    {
+        const juce::ScopedWriteLock lock (streamsLock);
+        streams.removeFirstMatchingValue (stream);
+    }
+
+    /** Wakes a worker, posts at most one wake-up until a worker picks it up. Realtime safe. */
+    void notify() noexcept
+    {
+        if (! wakeUpPending.exchange (true))
+            wakeUp.signal();
+    }
+
+    /** Restarts the workers, an affinityMask of 0 lets them run on any core. */
+    void setNumWorkers (int numWorkers, juce::uint32 affinityMask = 0)
+    {
+        stopWorkers();
+
+        for (int i = 0; i < juce::jmax (1, numWorkers); ++i)
+        {
+            auto* worker = workers.add (new Worker (*this));
+            if (affinityMask != 0)
+                worker->setAffinityMask (affinityMask);
+            worker->startThread (5);
+        }
+    }
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        explicit Worker (AnalysisService& s) : juce::Thread ("Analysis-Worker"), service (s) {}
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                service.wakeUpPending = false;
+
+                if (! service.processStreams())
+                    service.wakeUp.wait (1000);
+            }
+        }
+
+    private:
+        AnalysisService& service;
+    };
+
+    // one frame of each stream which has data, starting after the one processed last
+    bool processStreams()
+    {
+        const juce::ScopedReadLock lock (streamsLock);
+
+        const int numStreams = streams.size();
+        const auto start = nextStream.fetch_add (1);
+        bool didWork = false;
+
+        for (int i = 0; i < numStreams; ++i)
+        {
+            auto* stream = streams.getUnchecked (int ((start + unsigned (i)) % unsigned (numStreams)));
+
+            if (stream->isBeingProcessed.exchange (true))
+                continue;
+
+            didWork = stream->processNextFrame() || didWork;
+            stream->isBeingProcessed = false;
+        }
+
+        return didWork;
+    }
+
+    void stopWorkers()
+    {
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        wakeUp.signal();
+        for (auto* worker : workers)
+        {
+            wakeUp.signal();
+            worker->stopThread (1000);
+        }
+
+        workers.clear();
+    }
+
+    juce::ReadWriteLock streamsLock;
+    juce::Array<Stream*> streams;
+    std::atomic<unsigned int> nextStream { 0 };
+
+    juce::WaitableEvent wakeUp;
+    std::atomic<bool> wakeUpPending { false };
+
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisService)
+};
@@ -30,8 +30,7 @@ typedef std::vector<std::unique_ptr<juce::RangedAudioParameter>> ParameterList;
 
 class AudioProcessorBase : public juce::AudioProcessor,
                            public OSCMessageInterceptor,
-                           public juce::VSTCallbackHandler,
-                           public juce::AudioProcessorValueTreeState::Listener
+                           public juce::VSTCallbackHandler
 {
 public:
     AudioProcessorBase() :
@@ -25,7 +25,7 @@
 //==============================================================================
 /*
 */
-class LevelMeter : public juce::Component
+class LevelMeter : public juce::Component, public juce::TooltipClient
 {
     class Overlay : public juce::Component
     {
@@ -46,6 +46,8 @@ class LevelMeter : public juce::Component
 
         const float getOffset() { return offset; }
 
+        float getMinLevel() const { return minLevel; }
+
         const float getMeterHeight() { return getHeight() - 2; }
 
         const juce::Rectangle<int> getMeterArea() { return meterArea; }
@@ -155,6 +157,21 @@ public:
 
         g.setColour (levelColour);
         g.fillRect (lvlRect);
+
+        if (showsRms)
+        {
+            g.setColour (levelColour.brighter (0.6f));
+            g.fillRect (juce::Rectangle<int> (juce::Point<int> (meterArea.getX(), height),
+                                              juce::Point<int> (meterArea.getRight(), overlay.decibelsToY (rms))));
+        }
+
+        if (showsLoudness)
+        {
+            g.setColour (juce::Colours::white.withAlpha (0.8f));
+            g.fillRect (getMarkerArea (loudness.shortTerm));
+            g.setColour (juce::Colours::red);
+            g.fillRect (getMarkerArea (loudness.truePeak));
+        }
     }
 
     void setColour (juce::Colour newColour)
@@ -163,13 +180,60 @@ public:
         repaint();
     }
 
-    void setLevel (const float newLevel)
+    /** Returns true and repaints the changed part of the meter, if the level moved by at least a pixel. */
+    bool setLevel (const float newLevel)
     {
-        if (level != newLevel)
-        {
-            level = newLevel;
-            repaint();
-        }
+        if (level == newLevel)
+            return false;
+
+        const float oldLevel = level;
+        level = newLevel;
+        return repaintLevelChange (oldLevel, newLevel);
+    }
+
+    /** Shows the RMS level as a brighter bar inside the peak level, and in the tooltip.
+        Returns true, if the bar moved by at least a pixel. */
+    bool setRms (const float newRms)
+    {
+        if (showsRms && rms == newRms)
+            return false;
+
+        const float oldRms = showsRms ? rms : overlay.getMinLevel();
+        rms = newRms;
+        showsRms = true;
+        return repaintLevelChange (oldRms, newRms);
+    }
+
+    /** Shows the short-term loudness and the true peak as markers, and all values in the tooltip.
+        Returns true, if a marker moved. */
+    bool setLoudness (const float momentary, const float shortTerm, const float truePeak, const float crestFactor)
+    {
+        loudness.momentary = momentary;
+        loudness.crestFactor = crestFactor;
+
+        const bool wasShowingLoudness = showsLoudness;
+        showsLoudness = true;
+
+        bool hasMoved = ! wasShowingLoudness;
+        hasMoved |= moveMarker (loudness.shortTerm, shortTerm, wasShowingLoudness);
+        hasMoved |= moveMarker (loudness.truePeak, truePeak, wasShowingLoudness);
+        return hasMoved;
+    }
+
+    juce::String getTooltip() override
+    {
+        juce::StringArray lines;
+
+        if (showsRms)
+            lines.add ("Peak " + juce::String (level, 1) + " dB, RMS " + juce::String (rms, 1) + " dB");
+
+        if (showsLoudness)
+            lines.add ("M " + juce::String (loudness.momentary, 1) + " LUFS, S "
+                       + juce::String (loudness.shortTerm, 1) + " LUFS\nTrue peak "
+                       + juce::String (loudness.truePeak, 1) + " dBTP, crest "
+                       + juce::String (loudness.crestFactor, 1) + " dB");
+
+        return lines.joinIntoString ("\n");
     }
 
     void setMinLevel (float newMinLevel)
@@ -181,12 +245,60 @@ public:
     void resized() override { overlay.setBounds (getLocalBounds()); }
 
 private:
+    // repaints the part of the meter between two levels
+    bool repaintLevelChange (const float oldLevel, const float newLevel)
+    {
+        const int oldY = static_cast<int> (overlay.decibelsToY (oldLevel));
+        const int newY = static_cast<int> (overlay.decibelsToY (newLevel));
+
+        if (oldY == newY)
+            return false;
+
+        const auto meterArea = overlay.getMeterArea();
+        repaint (meterArea.withTop (juce::jmax (meterArea.getY(), juce::jmin (oldY, newY) - 1))
+                     .withBottom (juce::jmin (meterArea.getBottom(), juce::jmax (oldY, newY) + 1)));
+        return true;
+    }
+
+    juce::Rectangle<int> getMarkerArea (const float dB)
+    {
+        const auto meterArea = overlay.getMeterArea();
+        const int y = juce::jlimit (meterArea.getY(), meterArea.getBottom() - 2, static_cast<int> (overlay.decibelsToY (dB)) - 1);
+        return meterArea.withY (y).withHeight (2);
+    }
+
+    bool moveMarker (float& marker, const float newValue, const bool isVisible)
+    {
+        const auto oldArea = getMarkerArea (marker);
+        marker = newValue;
+        const auto newArea = getMarkerArea (marker);
+
+        if (isVisible && oldArea == newArea)
+            return false;
+
+        repaint (oldArea.getUnion (newArea));
+        return true;
+    }
+
     Overlay overlay;
 
+    struct Loudness
+    {
+        float momentary = -100.0f; // LUFS
+        float shortTerm = -100.0f; // LUFS
+        float truePeak = -100.0f; // dBTP
+        float crestFactor = 0.0f; // dB
+    };
+
+    Loudness loudness;
+    bool showsLoudness = false;
+
     juce::Colour levelColour = juce::Colour (juce::Colours::green);
 
     bool isGRmeter = false;
     float level = 0.0f;
+    float rms = 0.0f;
+    bool showsRms = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
 };
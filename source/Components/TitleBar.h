@@ -496,7 +496,7 @@ private:
 
 // ======================================================== TITLEBAR =========================
 template <class Tin, class Tout>
-class TitleBar : public juce::Component
+class TitleBar : public juce::Component, public juce::SettableTooltipClient
 {
 public:
     TitleBar() : juce::Component()
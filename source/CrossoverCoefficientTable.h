@@ -0,0 +1,128 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <vector>
+
+/* Precalculated 2nd order Butterworth coefficients for crossover frequencies
+ between 20 Hz and 20 kHz, so retuning a crossover is a table lookup.
+
+ The grid is logarithmic per octave and linear within each octave, which lets
+ lookup() find its position with frexp instead of a logarithm. */
+
+class CrossoverCoefficientTable
+{
+public:
+    // low pass b = { lowPassB0, 2 lowPassB0, lowPassB0 }, high pass b = { highPassB0, -2 highPassB0, highPassB0 }
+    struct Entry
+    {
+        float lowPassB0;
+        float highPassB0;
+        float a1;
+        float a2;
+    };
+
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+    static constexpr int entriesPerOctave = 128;
+
+    // 2nd order Butterworth sections as { b0, b1, b2, a1, a2 }, normalised to a0 = 1
+    static void calculateButterworthCoefficients (const double frequency,
+                                                  const double sampleRate,
+                                                  double* lowPass,
+                                                  double* highPass)
+    {
+        const double K = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        const double den = 1 + juce::MathConstants<double>::sqrt2 * K + pow (K, double (2.0));
+
+        // calculate coeffs for 2nd order Butterworth
+        const double a1 = (2 * (pow (K, 2.0) - 1)) / den;
+        const double a2 = (1 - juce::MathConstants<double>::sqrt2 * K + pow (K, 2.0)) / den;
+
+        // LP
+        lowPass[0] = pow (K, 2.0) / den;
+        lowPass[1] = 2.0 * lowPass[0];
+        lowPass[2] = lowPass[0];
+        lowPass[3] = a1;
+        lowPass[4] = a2;
+
+        // HP
+        highPass[0] = 1.0 / den;
+        highPass[1] = -2.0 * highPass[0];
+        highPass[2] = highPass[0];
+        highPass[3] = a1;
+        highPass[4] = a2;
+    }
+
+    /** Rebuilds the table, if the sample rate has changed. Not realtime safe. */
+    void prepare (const double newSampleRate)
+    {
+        if (newSampleRate == sampleRate)
+            return;
+
+        sampleRate = newSampleRate;
+
+        const float maxPosition = float (std::log2 (maxFrequency / minFrequency));
+        const int numEntries = int (std::ceil (maxPosition * entriesPerOctave)) + 2;
+        table.resize (size_t (numEntries));
+
+        for (int i = 0; i < numEntries; ++i)
+        {
+            const int octave = i / entriesPerOctave;
+            const double fraction = double (i % entriesPerOctave) / entriesPerOctave;
+            const double frequency = juce::jmin (std::ldexp (minFrequency * (1.0 + fraction), octave),
+                                                 0.499 * sampleRate);
+
+            double lp[5], hp[5];
+            calculateButterworthCoefficients (frequency, sampleRate, lp, hp);
+            table[size_t (i)] = { float (lp[0]), float (hp[0]), float (lp[3]), float (lp[4]) };
+        }
+    }
+
+    /** Interpolated coefficients for a crossover frequency. Realtime safe. */
+    Entry lookup (const float frequency) const noexcept
+    {
+        jassert (! table.empty());
+
+        const float ratio = juce::jlimit (1.0f, maxFrequency / minFrequency, frequency / minFrequency);
+
+        // ratio = mantissa * 2^exponent, with mantissa in [0.5, 1)
+        int exponent;
+        const float mantissa = std::frexp (ratio, &exponent);
+        const float position = (float (exponent - 1) + 2.0f * mantissa - 1.0f) * entriesPerOctave;
+
+        const int index = juce::jmin (int (position), int (table.size()) - 2);
+        const float alpha = position - float (index);
+
+        const Entry& e0 = table[size_t (index)];
+        const Entry& e1 = table[size_t (index + 1)];
+        return { e0.lowPassB0 + alpha * (e1.lowPassB0 - e0.lowPassB0),
+                 e0.highPassB0 + alpha * (e1.highPassB0 - e0.highPassB0),
+                 e0.a1 + alpha * (e1.a1 - e0.a1),
+                 e0.a2 + alpha * (e1.a2 - e0.a2) };
+    }
+
+private:
+    double sampleRate = 0.0;
+    std::vector<Entry> table;
+};
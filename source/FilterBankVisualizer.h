@@ -23,6 +23,8 @@
 #pragma once
 #include <set>
 
+#include "AnalyserOverlay.h"
+
 // ============================
 
 struct Settings
@@ -98,6 +100,36 @@ struct Settings
     }
 
     float xToHz (int x) { return fMin * pow ((fMax / fMin), ((x - mL) / width)); }
+
+    // cos (k w) and sin (k w) of every pixel frequency for k = 1 .. maxTableOrder, so filter
+    // responses are evaluated with multiply-adds instead of a complex exp per pixel
+    static constexpr int maxTableOrder = 4;
+    juce::Array<double> cosTable[maxTableOrder], sinTable[maxTableOrder];
+    double tableSampleRate = 0.0;
+    int tableVersion = 0;
+
+    void updateDelayTables()
+    {
+        const int numFrequencies = frequencies.size();
+        for (int k = 0; k < maxTableOrder; ++k)
+        {
+            cosTable[k].resize (numFrequencies);
+            sinTable[k].resize (numFrequencies);
+        }
+
+        for (int i = 0; i < numFrequencies; ++i)
+        {
+            const double w = juce::MathConstants<double>::twoPi * frequencies[i] / sampleRate;
+            for (int k = 0; k < maxTableOrder; ++k)
+            {
+                cosTable[k].setUnchecked (i, std::cos ((k + 1) * w));
+                sinTable[k].setUnchecked (i, std::sin ((k + 1) * w));
+            }
+        }
+
+        tableSampleRate = sampleRate;
+        ++tableVersion;
+    }
 };
 
 // ============================
@@ -243,7 +275,7 @@ template <typename coeffType>
 class FrequencyBand : public juce::Component
 {
 public:
-    FrequencyBand (Settings& settings) : s (settings) {};
+    FrequencyBand (Settings& settings) : s (settings) { setBufferedToImage (true); };
 
     FrequencyBand (Settings& settings,
                    typename juce::dsp::IIR::Coefficients<coeffType>::Ptr coeffs1,
@@ -251,6 +283,7 @@ public:
                    juce::Colour newColour) :
         s (settings), colour (newColour)
     {
+        setBufferedToImage (true);
         addCoeffs (coeffs1, coeffs2);
     };
 
@@ -271,6 +304,11 @@ public:
         magnitudes.fill (1.0f);
         magnitudesIncludingGains.resize (s.numPixels);
         magnitudesIncludingGains.fill (1.0f);
+
+        for (auto* scratch : { &numeratorRe, &numeratorIm, &denominatorRe, &denominatorIm })
+            scratch->resize (s.numPixels);
+
+        evaluatedCoeffs.clear();
     }
 
     void updateMakeUpGain (const float& newMakeUp)
@@ -291,27 +329,28 @@ public:
         }
     }
 
+    // recalculates the response only if the coefficients or the frequency tables have changed
     void updateFilterResponse()
     {
-        juce::Array<double> tempMagnitude;
-        tempMagnitude.resize (s.numPixels);
-        tempMagnitude.fill (1.0f);
-        for (int i = 0; i < coeffs.size(); ++i)
+        if (s.numPixels <= 0 || magnitudes.size() != s.numPixels || ! responseIsOutdated())
+            return;
+
+        evaluatedCoeffs.clearQuick();
+        evaluatedTableVersion = s.tableVersion;
+
+        // squared magnitudes are multiplied, the square root is taken once at the end
+        magnitudes.fill (1.0);
+        for (auto& c : coeffs)
         {
-            juce::Array<double> filterMagnitude;
-            filterMagnitude.resize (s.numPixels);
-            if (coeffs[i] != nullptr)
-                coeffs[i]->getMagnitudeForFrequencyArray (s.frequencies.getRawDataPointer(),
-                                                          filterMagnitude.getRawDataPointer(),
-                                                          s.numPixels,
-                                                          s.sampleRate);
-            juce::FloatVectorOperations::multiply (tempMagnitude.getRawDataPointer(),
-                                                   filterMagnitude.getRawDataPointer(),
-                                                   s.numPixels);
+            evaluatedCoeffs.add (c != nullptr ? c->coefficients : juce::Array<coeffType>());
+            if (c != nullptr)
+                multiplyBySquaredMagnitude (c->coefficients);
         }
-        juce::FloatVectorOperations::copy (magnitudes.getRawDataPointer(),
-                                           tempMagnitude.getRawDataPointer(),
-                                           s.numPixels);
+
+        auto* m = magnitudes.getRawDataPointer();
+        for (int i = 0; i < s.numPixels; ++i)
+            m[i] = std::sqrt (m[i]);
+
         updatePath();
     }
 
@@ -329,8 +368,13 @@ public:
             gain2 = 0.0f;
         }
 
+        if (s.numPixels > 0)
+            juce::FloatVectorOperations::multiply (magnitudesIncludingGains.getRawDataPointer(),
+                                                   magnitudes.getRawDataPointer(),
+                                                   juce::Decibels::decibelsToGain (double (gain1 + gain2)),
+                                                   s.numPixels);
+
         float db = juce::Decibels::gainToDecibels (magnitudes[0]) + gain1 + gain2;
-        magnitudesIncludingGains.set (0, juce::Decibels::decibelsToGain (db));
         path.startNewSubPath (s.xMin,
                               juce::jlimit (static_cast<float> (s.yMin),
                                             static_cast<float> (s.yMax) + s.OH + 1.0f,
@@ -339,7 +383,6 @@ public:
         for (int i = 1; i < s.numPixels; ++i)
         {
             db = juce::Decibels::gainToDecibels (magnitudes[i]) + gain1 + gain2;
-            magnitudesIncludingGains.set (i, juce::Decibels::decibelsToGain (db));
             float y = juce::jlimit (static_cast<float> (s.yMin),
                                     static_cast<float> (s.yMax) + s.OH + 1.0f,
                                     s.dbToYFloat (db));
@@ -351,9 +394,13 @@ public:
         closedPath.lineTo (s.xMin, s.yMax + s.OH + 1.0f);
         closedPath.closeSubPath();
 
+        ++responseVersion;
         repaint();
     }
 
+    // changes whenever getMagnitudeIncludingGains() does
+    int getResponseVersion() const { return responseVersion; }
+
     double* getMagnitudeIncludingGains() { return magnitudesIncludingGains.getRawDataPointer(); }
 
     juce::Array<double> getMagnitudeIncludingGainsArray() const { return magnitudesIncludingGains; }
@@ -371,18 +418,85 @@ public:
     {
         coeffs.add (coeffs1);
         coeffs.add (coeffs2);
+        evaluatedCoeffs.clear();
     }
 
 private:
+    bool responseIsOutdated() const
+    {
+        if (evaluatedTableVersion != s.tableVersion || evaluatedCoeffs.size() != coeffs.size())
+            return true;
+
+        for (int i = 0; i < coeffs.size(); ++i)
+            if (coeffs[i] != nullptr && coeffs[i]->coefficients != evaluatedCoeffs.getReference (i))
+                return true;
+
+        return false;
+    }
+
+    // |b0 + b1 z^-1 + ...|^2 / |1 + a1 z^-1 + ...|^2 at every pixel, with z^-k from the delay tables
+    void multiplyBySquaredMagnitude (const juce::Array<coeffType>& c)
+    {
+        const int order = (c.size() - 1) / 2;
+        const int n = s.numPixels;
+        auto* m = magnitudes.getRawDataPointer();
+
+        if (order > Settings::maxTableOrder)
+        {
+            juce::dsp::IIR::Coefficients<double> fallback;
+            for (auto value : c)
+                fallback.coefficients.add (double (value));
+
+            fallback.getMagnitudeForFrequencyArray (s.frequencies.getRawDataPointer(),
+                                                    numeratorRe.getRawDataPointer(),
+                                                    n,
+                                                    s.sampleRate);
+            juce::FloatVectorOperations::multiply (m, numeratorRe.getRawDataPointer(), n);
+            juce::FloatVectorOperations::multiply (m, numeratorRe.getRawDataPointer(), n);
+            return;
+        }
+
+        auto* nRe = numeratorRe.getRawDataPointer();
+        auto* nIm = numeratorIm.getRawDataPointer();
+        auto* dRe = denominatorRe.getRawDataPointer();
+        auto* dIm = denominatorIm.getRawDataPointer();
+
+        // the sign of the imaginary parts doesn't matter for the magnitude
+        juce::FloatVectorOperations::fill (nRe, double (c[0]), n);
+        juce::FloatVectorOperations::clear (nIm, n);
+        juce::FloatVectorOperations::fill (dRe, 1.0, n);
+        juce::FloatVectorOperations::clear (dIm, n);
+
+        for (int k = 1; k <= order; ++k)
+        {
+            const auto* cosTable = s.cosTable[k - 1].getRawDataPointer();
+            const auto* sinTable = s.sinTable[k - 1].getRawDataPointer();
+
+            juce::FloatVectorOperations::addWithMultiply (nRe, cosTable, double (c[k]), n);
+            juce::FloatVectorOperations::addWithMultiply (nIm, sinTable, double (c[k]), n);
+            juce::FloatVectorOperations::addWithMultiply (dRe, cosTable, double (c[order + k]), n);
+            juce::FloatVectorOperations::addWithMultiply (dIm, sinTable, double (c[order + k]), n);
+        }
+
+        for (int i = 0; i < n; ++i)
+            m[i] *= (nRe[i] * nRe[i] + nIm[i] * nIm[i]) / (dRe[i] * dRe[i] + dIm[i] * dIm[i]);
+    }
+
     Settings& s;
     juce::Array<typename juce::dsp::IIR::Coefficients<coeffType>::Ptr> coeffs;
 
+    // coefficients and delay tables the current magnitudes were evaluated with
+    juce::Array<juce::Array<coeffType>> evaluatedCoeffs;
+    int evaluatedTableVersion = -1;
+    int responseVersion = 0;
+
     juce::Colour colour;
     bool bypassed { false };
 
     float makeUp = 0.0f, gainReduction = 0.0f;
 
     juce::Array<double> magnitudes, magnitudesIncludingGains;
+    juce::Array<double> numeratorRe, numeratorIm, denominatorRe, denominatorIm;
     juce::Path path, closedPath;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrequencyBand);
@@ -395,7 +509,10 @@ class OverallMagnitude : public juce::Component
 {
 public:
     OverallMagnitude (Settings& settings, int numFreqBands) :
-        s (settings), numBands (numFreqBands), overallGain (0.0f) {};
+        s (settings), numBands (numFreqBands), overallGain (0.0f)
+    {
+        setBufferedToImage (true);
+    };
 
     ~OverallMagnitude() {};
 
@@ -412,18 +529,29 @@ public:
     {
         overallMagnitude.resize (s.numPixels);
         overallMagnitude.fill (overallGain);
+        summedVersions.clear();
     }
 
-    void setOverallGain (const float newGain) { overallGain = newGain; }
+    void setOverallGain (const float newGain)
+    {
+        overallGain = newGain;
+        summedVersions.clear();
+    }
 
+    // sums the bands again only if one of them has changed since the last call
     void updateOverallMagnitude()
     {
+        if (freqBands == nullptr || ! sumIsOutdated())
+            return;
+
+        summedVersions.clearQuick();
         overallMagnitude.fill (overallGain);
         for (int i = 0; i < (*freqBands).size(); ++i)
         {
             juce::FloatVectorOperations::add (overallMagnitude.getRawDataPointer(),
                                               (*freqBands)[i]->getMagnitudeIncludingGains(),
                                               s.numPixels);
+            summedVersions.add ((*freqBands)[i]->getResponseVersion());
         }
 
         updatePath();
@@ -463,8 +591,21 @@ public:
     }
 
 private:
+    bool sumIsOutdated() const
+    {
+        if (summedVersions.size() != (*freqBands).size())
+            return true;
+
+        for (int i = 0; i < (*freqBands).size(); ++i)
+            if ((*freqBands)[i]->getResponseVersion() != summedVersions[i])
+                return true;
+
+        return false;
+    }
+
     Settings& s;
-    juce::OwnedArray<FrequencyBand<coefficientType>>* freqBands;
+    juce::OwnedArray<FrequencyBand<coefficientType>>* freqBands = nullptr;
+    juce::Array<int> summedVersions;
 
     juce::Array<double> overallMagnitude;
     juce::Path path, closedPath;
@@ -503,6 +644,7 @@ public:
         updateSettings();
 
         addAndMakeVisible (&filterBackdrop);
+        addAndMakeVisible (&analyserOverlay);
 
         for (int i = 0; i < numFreqBands; ++i)
         {
@@ -515,6 +657,8 @@ public:
             activateOverallMagnitude();
 
         freqBandColours.resize (numFreqBands);
+        for (int i = 0; i < numFreqBands; ++i)
+            bandSpectrumTraces.add (analyserOverlay.addTrace (juce::Colours::transparentBlack));
     }
 
     void updateSettings()
@@ -533,9 +677,9 @@ public:
         s.frequencies.resize (s.numPixels < 0 ? 0.0f : s.numPixels);
         for (int i = 0; i < s.frequencies.size(); ++i)
             s.frequencies.set (i, s.xToHz (s.xMin + i));
-    }
 
-    void paint (juce::Graphics& g) override {}
+        s.updateDelayTables();
+    }
 
     void paintOverChildren (juce::Graphics& g) override
     {
@@ -569,6 +713,7 @@ public:
 
         juce::Rectangle<int> area = getLocalBounds();
         filterBackdrop.setBounds (area);
+        analyserOverlay.setBounds (area);
         for (int i = 0; i < freqBands.size(); ++i)
         {
             freqBands[i]->setBounds (area);
@@ -635,11 +780,14 @@ public:
 
     void updateFreqBandResponse (const int freqBand)
     {
+        updateDelayTablesIfSampleRateChanged();
         freqBands[freqBand]->updateFilterResponse();
     }
 
+    // only bands whose coefficients have changed are recalculated
     void updateFreqBandResponses()
     {
+        updateDelayTablesIfSampleRateChanged();
         for (int i = 0; i < numFreqBands; ++i)
             freqBands[i]->updateFilterResponse();
     }
@@ -680,6 +828,7 @@ public:
         freqBands[i]->updateFilterResponse();
 
         freqBandColours.set (i, colour);
+        analyserOverlay.setTraceColour (bandSpectrumTraces[i], colour.withMultipliedAlpha (0.6f));
     }
 
     void addFrequencyBand (typename juce::dsp::IIR::Coefficients<T>::Ptr coeffs1,
@@ -690,6 +839,7 @@ public:
         addAndMakeVisible (freqBands.getLast());
 
         freqBandColours.add (colour);
+        bandSpectrumTraces.add (analyserOverlay.addTrace (colour.withMultipliedAlpha (0.6f)));
     }
 
     void activateOverallMagnitude (const float gain = 0.0f)
@@ -719,10 +869,34 @@ public:
         crossoverSliders.add (crossoverSlider);
     }
 
+    // traces on top of the backdrop and underneath the filter responses
+    AnalyserOverlay& getAnalyserOverlay() { return analyserOverlay; }
+
+    // createPath fills the spectrum of a band, e.g. within getSpectrumArea()
+    template <typename CreatePath>
+    bool updateBandSpectrum (const int i, CreatePath&& createPath)
+    {
+        return analyserOverlay.updateTrace (bandSpectrumTraces[i], std::forward<CreatePath> (createPath));
+    }
+
+    // area for spectra covering 10 octaves from fMin, aligned with the filter responses
+    juce::Rectangle<float> getSpectrumArea()
+    {
+        const float tenOctavesWidth = (s.xMax - s.xMin) * 10.0f / std::log2 (s.fMax / s.fMin);
+        return { float (s.xMin), float (s.yMin), tenOctavesWidth, float (s.yMax - s.yMin) };
+    }
+
 private:
+    void updateDelayTablesIfSampleRateChanged()
+    {
+        if (s.sampleRate != s.tableSampleRate)
+            s.updateDelayTables();
+    }
+
     Settings s;
 
     FilterBackdrop filterBackdrop;
+    AnalyserOverlay analyserOverlay;
     juce::OwnedArray<FrequencyBand<T>> freqBands;
     OverallMagnitude<T> overallMagnitude;
 
@@ -733,6 +907,7 @@ private:
 
     juce::Colour colour { 0xFFD8D8D8 };
     juce::Array<juce::Colour> freqBandColours;
+    juce::Array<int> bandSpectrumTraces;
 
     std::set<int> soloSet;
 
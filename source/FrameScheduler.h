@@ -0,0 +1,181 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_events/juce_events.h>
+
+/* One message thread timer for all periodic GUI and OSC updates of a process,
+ use it through a juce::SharedResourcePointer<FrameScheduler>.
+
+ Clients which are due at about the same time are called in the same frame, so
+ their repaints are coalesced. A client which hasn't reported a change for a
+ while falls back to its idle interval, and all intervals are stretched while
+ the audio thread reports a high load.
+
+ Clients can be added, removed and poked from any thread, their callbacks
+ always run on the message thread. */
+
+class FrameScheduler : private juce::Timer
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /** Called on the message thread, returns true if anything has changed. */
+        virtual bool frameCallback() = 0;
+
+    private:
+        friend class FrameScheduler;
+        int interval = 50;
+        int idleInterval = 50;
+        double nextFrame = 0.0;
+        double lastChange = 0.0;
+    };
+
+    static constexpr double idleAfterMs = 1000.0; // without changes, until a client counts as idle
+    static constexpr double frameSlackMs = 8.0; // clients due within this are called in the same frame
+
+    FrameScheduler() = default;
+
+    ~FrameScheduler() override { stopTimer(); }
+
+    /** Adds a client, an idleInterval of 0 disables backing off. */
+    void addClient (Client* client, const int interval, const int idleInterval = 250)
+    {
+        const juce::ScopedLock sl (lock);
+
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        client->interval = juce::jmax (1, interval);
+        client->idleInterval = juce::jmax (client->interval, idleInterval);
+        client->nextFrame = now;
+        client->lastChange = now;
+
+        clients.addIfNotAlreadyThere (client);
+        dueClients.ensureStorageAllocated (clients.size());
+        scheduleNextFrame (now);
+    }
+
+    /** Returns when the client's callback isn't running anymore. */
+    void removeClient (Client* client)
+    {
+        const juce::ScopedLock sl (lock);
+
+        clients.removeFirstMatchingValue (client);
+        if (clients.isEmpty())
+            stopTimer();
+    }
+
+    void setInterval (Client* client, const int newInterval)
+    {
+        const juce::ScopedLock sl (lock);
+
+        const int idleDistance = client->idleInterval - client->interval;
+        client->interval = juce::jmax (1, newInterval);
+        client->idleInterval = client->interval + idleDistance;
+        requestFrame (client);
+    }
+
+    int getInterval (const Client* client) const
+    {
+        const juce::ScopedLock sl (lock);
+        return client->interval;
+    }
+
+    /** Calls the client as soon as possible and keeps it at its full rate, e.g. on user interaction. */
+    void requestFrame (Client* client)
+    {
+        const juce::ScopedLock sl (lock);
+
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        client->nextFrame = now;
+        client->lastChange = now;
+
+        if (clients.contains (client))
+            scheduleNextFrame (now);
+    }
+
+    /** The fraction of a block's duration the audio thread needed to process it. Realtime safe. */
+    void reportAudioLoad (const float load) noexcept
+    {
+        auto current = reportedLoad.load (std::memory_order_relaxed);
+        while (load > current && ! reportedLoad.compare_exchange_weak (current, load))
+        {
+        }
+    }
+
+    /** Highest recent audio load, decaying while no higher load is reported. */
+    float getLoadPressure() const noexcept { return loadPressure; }
+
+private:
+    void timerCallback() override
+    {
+        // held during the callbacks, so a client can't be removed while it's being called
+        const juce::ScopedLock sl (lock);
+
+        const double now = juce::Time::getMillisecondCounterHiRes();
+
+        loadPressure = juce::jmax (reportedLoad.exchange (0.0f), 0.8f * loadPressure);
+        const int throttle = loadPressure > 0.9f ? 4 : (loadPressure > 0.7f ? 2 : 1);
+
+        // clients may add or remove clients from their callbacks
+        dueClients.clearQuick();
+        for (auto* client : clients)
+            if (client->nextFrame <= now + frameSlackMs)
+                dueClients.add (client);
+
+        for (auto* client : dueClients)
+        {
+            if (! clients.contains (client))
+                continue;
+
+            if (client->frameCallback())
+                client->lastChange = now;
+
+            const bool isIdle = now - client->lastChange > idleAfterMs;
+            client->nextFrame = now + throttle * (isIdle ? client->idleInterval : client->interval);
+        }
+
+        scheduleNextFrame (now);
+    }
+
+    void scheduleNextFrame (const double now)
+    {
+        if (clients.isEmpty())
+            return;
+
+        double nextFrame = clients.getFirst()->nextFrame;
+        for (auto* client : clients)
+            nextFrame = juce::jmin (nextFrame, client->nextFrame);
+
+        startTimer (juce::jmax (1, juce::roundToInt (nextFrame - now)));
+    }
+
+    // guards the clients and their timing, reentrant for the callbacks
+    juce::CriticalSection lock;
+    juce::Array<Client*> clients, dueClients;
+
+    std::atomic<float> reportedLoad { 0.0f };
+    float loadPressure = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameScheduler)
+};
@@ -0,0 +1,136 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "LoadMeter.h"
+
+/* The DSP load and the xruns of a LoadMeter, above the histogram of its
+ block loads: zero load at the left, the real-time budget in the middle and
+ twice the budget at the right. Clicking it resets the meter. */
+
+class LoadDisplay : public juce::Component, public juce::TooltipClient
+{
+public:
+    explicit LoadDisplay (LoadMeter& meterToShow) : meter (meterToShow)
+    {
+        setMouseCursor (juce::MouseCursor::PointingHandCursor);
+    }
+
+    /** Fetches the meter's statistics, returns true if the display has changed. */
+    bool update()
+    {
+        const auto newStatistics = meter.getStatistics();
+        int newCounts[LoadMeter::numBins];
+        meter.getHistogram (newCounts);
+
+        const bool textHasChanged = juce::roundToInt (100.0f * newStatistics.load) != juce::roundToInt (100.0f * statistics.load)
+                                    || newStatistics.numXruns != statistics.numXruns;
+        const bool histogramHasChanged = ! std::equal (std::begin (newCounts), std::end (newCounts), std::begin (counts));
+
+        statistics = newStatistics;
+        std::copy (std::begin (newCounts), std::end (newCounts), std::begin (counts));
+
+        if (! textHasChanged && ! histogramHasChanged)
+            return false;
+
+        repaint();
+        return true;
+    }
+
+    /** Audio blocks the analysers dropped, shown in the tooltip. */
+    void setNumDroppedAnalyserBlocks (const int newNumDroppedBlocks) { numDroppedAnalyserBlocks = newNumDroppedBlocks; }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto bounds = getLocalBounds().toFloat().reduced (1.0f);
+
+        g.setColour (juce::Colours::black.withAlpha (0.4f));
+        g.fillRoundedRectangle (bounds, 3.0f);
+
+        g.setFont (getLookAndFeel().getTypefaceForFont (juce::Font (12.0f, 0)));
+        g.setFont (12.0f);
+
+        auto textArea = bounds.removeFromTop (16.0f).reduced (4.0f, 0.0f);
+        g.setColour (juce::Colours::white);
+        g.drawText ("DSP " + juce::String (juce::roundToInt (100.0f * statistics.load)) + " %",
+                    textArea,
+                    juce::Justification::centredLeft);
+        g.setColour (statistics.numXruns > 0 ? juce::Colours::red : juce::Colours::white.withAlpha (0.6f));
+        g.drawText (juce::String (statistics.numXruns) + (statistics.numXruns == 1 ? " xrun" : " xruns"),
+                    textArea,
+                    juce::Justification::centredRight);
+
+        // bar heights on a square root scale, so the rare slow blocks stay visible
+        const auto histogramArea = bounds.reduced (4.0f, 3.0f);
+        const int maxCount = *std::max_element (std::begin (counts), std::end (counts));
+        const float barWidth = histogramArea.getWidth() / LoadMeter::numBins;
+        const int budgetBin = juce::roundToInt (1.0f / LoadMeter::binWidth);
+
+        if (maxCount > 0)
+        {
+            for (int bin = 0; bin < LoadMeter::numBins; ++bin)
+            {
+                if (counts[bin] == 0)
+                    continue;
+
+                const float height = histogramArea.getHeight() * std::sqrt (float (counts[bin]) / maxCount);
+                g.setColour (bin < budgetBin ? juce::Colours::white.withAlpha (0.7f) : juce::Colours::red);
+                g.fillRect (histogramArea.getX() + bin * barWidth,
+                            histogramArea.getBottom() - juce::jmax (1.0f, height),
+                            juce::jmax (1.0f, barWidth),
+                            juce::jmax (1.0f, height));
+            }
+        }
+
+        g.setColour (juce::Colours::white.withAlpha (0.3f));
+        g.drawVerticalLine (juce::roundToInt (histogramArea.getX() + budgetBin * barWidth),
+                            histogramArea.getY(),
+                            histogramArea.getBottom());
+    }
+
+    void mouseDown (const juce::MouseEvent&) override
+    {
+        meter.reset();
+    }
+
+    juce::String getTooltip() override
+    {
+        auto percent = [] (const float proportion) { return juce::String (juce::roundToInt (100.0f * proportion)) + " %"; };
+
+        return "DSP load of the real-time budget: " + percent (statistics.load) + "\n"
+               + "last " + juce::String (LoadMeter::numWindows) + " s: median " + percent (statistics.p50) + ", p99 "
+               + percent (statistics.p99) + ", max " + percent (statistics.max) + ", "
+               + juce::String (statistics.numRecentXruns) + " of " + juce::String (statistics.numBlocks)
+               + " blocks over budget\n"
+               + juce::String (statistics.numXruns) + " xruns in total, click to reset\n"
+               + juce::String (numDroppedAnalyserBlocks) + " audio blocks dropped by the analysers";
+    }
+
+private:
+    LoadMeter& meter;
+    LoadMeter::Statistics statistics;
+    int counts[LoadMeter::numBins] = {};
+    int numDroppedAnalyserBlocks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadDisplay)
+};
@@ -0,0 +1,202 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/* Time spent in the audio callback compared to the real-time budget of the
+ block, its duration numSamples / sampleRate, like juce::AudioProcessLoadMeasurer.
+
+ Besides the smoothed load and the number of blocks which took longer than
+ their budget (xruns), the load of every block goes into a histogram. It
+ rolls over numWindows windows of a second each: the audio thread clears the
+ oldest window when it starts a new one, and readers add up all of them.
+
+ Only the audio thread writes, readers load the atomic counters; a reader may
+ see a window half cleared. reset() is carried out with the next block. */
+
+class LoadMeter
+{
+public:
+    static constexpr float binWidth = 0.025f; // of the budget
+    static constexpr int numBins = 81; // up to twice the budget, the last bin holds everything above
+    static constexpr int numWindows = 10;
+
+    struct Statistics
+    {
+        float load = 0.0f; // smoothed, of the budget
+        float p50 = 0.0f, p99 = 0.0f, max = 0.0f; // of the budget, over the last numWindows seconds
+        int numBlocks = 0; // over the last numWindows seconds
+        int numRecentXruns = 0; // over the last numWindows seconds
+        int numXruns = 0; // since the start or the last reset
+    };
+
+    LoadMeter() { clear(); }
+
+    /** Should be called in prepareToPlay(), but not while the audio thread is running. */
+    void prepare (const double sampleRate)
+    {
+        ticksPerSample = double (juce::Time::getHighResolutionTicksPerSecond()) / sampleRate;
+        windowLength = juce::jmax (1, juce::roundToInt (sampleRate));
+        clear();
+    }
+
+    //==============================================================================
+    // audio thread
+
+    /** Registers a block which started at startTicks (juce::Time::getHighResolutionTicks()),
+        and returns its load. */
+    float registerBlock (const juce::int64 startTicks, const int numSamples) noexcept
+    {
+        if (numSamples <= 0)
+            return 0.0f;
+
+        if (resetRequested.exchange (false))
+            clear();
+
+        const auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+        const float load = float (double (ticks) / (ticksPerSample * numSamples));
+
+        smoothedLoad += filterAmount * (load - smoothedLoad);
+        loadToRead.store (smoothedLoad, std::memory_order_relaxed);
+
+        if (load > 1.0f)
+            increment (numXruns);
+
+        // the oldest window is cleared when it becomes the current one
+        windowSamples += numSamples;
+        if (windowSamples >= windowLength)
+        {
+            windowSamples = 0;
+            currentWindow = (currentWindow + 1) % numWindows;
+            clearWindow (windows[currentWindow]);
+        }
+
+        auto& window = windows[currentWindow];
+        increment (window.bins[juce::jmin (numBins - 1, int (load / binWidth))]);
+        if (load > window.max.load (std::memory_order_relaxed))
+            window.max.store (load, std::memory_order_relaxed);
+
+        return load;
+    }
+
+    //==============================================================================
+    // any other thread
+
+    /** Forgets the histogram and the xruns, with the next block. */
+    void reset() noexcept { resetRequested = true; }
+
+    Statistics getStatistics() const noexcept
+    {
+        Statistics statistics;
+        statistics.load = loadToRead.load (std::memory_order_relaxed);
+        statistics.numXruns = numXruns.load (std::memory_order_relaxed);
+
+        int counts[numBins] = {};
+        for (auto& window : windows)
+        {
+            for (int bin = 0; bin < numBins; ++bin)
+                counts[bin] += window.bins[bin].load (std::memory_order_relaxed);
+            statistics.max = juce::jmax (statistics.max, window.max.load (std::memory_order_relaxed));
+        }
+
+        for (int bin = 0; bin < numBins; ++bin)
+            statistics.numBlocks += counts[bin];
+        for (int bin = int (1.0f / binWidth); bin < numBins; ++bin)
+            statistics.numRecentXruns += counts[bin];
+
+        statistics.p50 = getPercentile (counts, statistics.numBlocks, 0.5f, statistics.max);
+        statistics.p99 = getPercentile (counts, statistics.numBlocks, 0.99f, statistics.max);
+        return statistics;
+    }
+
+    /** Adds up the histogram of the last numWindows seconds, for displays. */
+    void getHistogram (int (&counts)[numBins]) const noexcept
+    {
+        std::fill (std::begin (counts), std::end (counts), 0);
+        for (auto& window : windows)
+            for (int bin = 0; bin < numBins; ++bin)
+                counts[bin] += window.bins[bin].load (std::memory_order_relaxed);
+    }
+
+private:
+    struct Window
+    {
+        std::atomic<int> bins[numBins];
+        std::atomic<float> max;
+    };
+
+    static void increment (std::atomic<int>& counter) noexcept
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static void clearWindow (Window& window) noexcept
+    {
+        for (auto& bin : window.bins)
+            bin.store (0, std::memory_order_relaxed);
+        window.max.store (0.0f, std::memory_order_relaxed);
+    }
+
+    // the upper edge of the bin, but not above the highest load seen
+    static float getPercentile (const int (&counts)[numBins], const int total, const float fraction, const float max) noexcept
+    {
+        const int rank = int (fraction * float (total));
+        int below = 0;
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            below += counts[bin];
+            if (below > rank)
+                return juce::jmin (max, float (bin + 1) * binWidth);
+        }
+
+        return 0.0f;
+    }
+
+    void clear() noexcept
+    {
+        for (auto& window : windows)
+            clearWindow (window);
+        numXruns.store (0, std::memory_order_relaxed);
+        loadToRead.store (0.0f, std::memory_order_relaxed);
+        smoothedLoad = 0.0f;
+        windowSamples = 0;
+        currentWindow = 0;
+    }
+
+    static constexpr float filterAmount = 0.2f; // as juce::AudioProcessLoadMeasurer
+
+    // audio thread only
+    double ticksPerSample = 1.0e6 / 48000.0;
+    int windowLength = 48000; // samples
+    int windowSamples = 0;
+    int currentWindow = 0;
+    float smoothedLoad = 0.0f;
+
+    // written by the audio thread only
+    Window windows[numWindows];
+    std::atomic<int> numXruns { 0 };
+    std::atomic<float> loadToRead { 0.0f };
+
+    std::atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadMeter)
+};
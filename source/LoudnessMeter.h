@@ -0,0 +1,597 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "AnalysisService.h"
+
+/* K-weighted loudness (ITU-R BS.1770 momentary and short-term), true peak and
+ crest factor of several multichannel signals, e.g. the input, the output and
+ the bands.
+
+ The audio thread only copies its interleaved SIMD blocks into a ring, the
+ filtering and the oversampling run on the analysis service, on the same
+ SIMD registers, so one register holds several channels. A band's gain ramp is
+ passed along and applied on the analysis thread as well. */
+
+template <typename SampleType, int numSignals>
+class LoudnessMeter : public AnalysisService::Stream
+{
+public:
+    static constexpr float minusInfinityDb = -100.0f;
+
+    struct Levels
+    {
+        float momentaryLoudness = minusInfinityDb; // LUFS, 400 ms
+        float shortTermLoudness = minusInfinityDb; // LUFS, 3 s
+        float truePeak = minusInfinityDb; // dBTP, 400 ms
+        float crestFactor = 0.0f; // dB, true peak over RMS, 400 ms
+    };
+
+    LoudnessMeter()
+    {
+        designInterpolator();
+
+        for (auto& signal : results)
+            for (auto& value : signal)
+                value = minusInfinityDb;
+    }
+
+    ~LoudnessMeter() override { stopMeter(); }
+
+    /** Allocates everything for blocks of up to maxBlockSize samples with numGroups
+        SIMD registers per signal, stops the meter. */
+    void setupMeter (const double sampleRateToUse, const int maxBlockSizeToUse, const int numGroupsToUse)
+    {
+        stopMeter();
+
+        sampleRate = sampleRateToUse;
+        maxBlockSize = juce::jmax (1, maxBlockSizeToUse);
+        maxNumGroups = juce::jmax (1, numGroupsToUse);
+        subBlockLength = juce::jmax (1, juce::roundToInt (0.1 * sampleRate));
+
+        // a few blocks, or 100 ms, for each signal and group
+        const int fifoLength = juce::jmax (4 * maxBlockSize, subBlockLength);
+        const int fifoSize = numSignals * maxNumGroups * fifoLength;
+        fifo = juce::dsp::AudioBlock<SampleType> (fifoData, 1, size_t (fifoSize));
+        abstractFifo.setTotalSize (fifoSize);
+        headerFifo.reset();
+
+        // signal, weighted, interpolator input, and the per sample sums over the groups
+        scratch = juce::dsp::AudioBlock<SampleType> (scratchData,
+                                                     numScratchChannels,
+                                                     size_t (maxBlockSize + numPhaseTaps));
+
+        auto shelf = makeShelf (sampleRate);
+        auto highPass = makeHighPass (sampleRate);
+        shelves.clear();
+        highPasses.clear();
+        for (int i = 0; i < numSignals * maxNumGroups; ++i)
+        {
+            shelves.add (new juce::dsp::IIR::Filter<SampleType> (shelf));
+            highPasses.add (new juce::dsp::IIR::Filter<SampleType> (highPass));
+        }
+
+        interpolatorHistory = juce::dsp::AudioBlock<SampleType> (interpolatorHistoryData,
+                                                                 size_t (numSignals * maxNumGroups),
+                                                                 size_t (numPhaseTaps));
+        reset();
+    }
+
+    void startMeter() { service->addStream (this); }
+    void stopMeter() { service->removeStream (this); }
+
+    //==============================================================================
+    // audio thread
+
+    /** Reserves room for a block, returns false if the block has to be dropped. */
+    bool beginBlock (const int numSamples, const int numGroups, const int numChannels) noexcept
+    {
+        blockIsOpen = false;
+
+        const int recordSize = numSignals * numGroups * numSamples;
+        if (numSamples > maxBlockSize || numGroups > maxNumGroups || numSamples < 1
+            || abstractFifo.getFreeSpace() < recordSize || headerFifo.getFreeSpace() < 1)
+        {
+            ++numDroppedBlocks;
+            return false;
+        }
+
+        abstractFifo.prepareToWrite (recordSize, start1, block1, start2, block2);
+
+        pendingHeader.numSamples = numSamples;
+        pendingHeader.numGroups = numGroups;
+        pendingHeader.numChannels = numChannels;
+        pendingHeader.writtenSignals = 0;
+        for (auto& gain : pendingHeader.gains)
+            gain = {};
+
+        blockIsOpen = true;
+        return true;
+    }
+
+    /** Copies a group of a signal, signals which aren't written for a block count as silent. */
+    void writeSignal (const int signal, const int group, const SampleType* data) noexcept
+    {
+        if (! blockIsOpen)
+            return;
+
+        const int numSamples = pendingHeader.numSamples;
+        int position = (signal * pendingHeader.numGroups + group) * numSamples;
+        int numLeft = numSamples;
+
+        // the first part of the record lives in block1, the rest in block2
+        if (position < block1)
+        {
+            const int n = juce::jmin (numLeft, block1 - position);
+            std::copy (data, data + n, fifo.getChannelPointer (0) + start1 + position);
+            data += n;
+            position += n;
+            numLeft -= n;
+        }
+        if (numLeft > 0)
+            std::copy (data, data + numLeft, fifo.getChannelPointer (0) + start2 + position - block1);
+
+        pendingHeader.writtenSignals |= 1u << signal;
+    }
+
+    /** The gain ramp applied to a signal, defaults to unity gain. */
+    void setGainRamp (const int signal, const float startGain, const float gainStep, const int numRampSamples, const float endGain) noexcept
+    {
+        pendingHeader.gains[signal] = { startGain, gainStep, numRampSamples, endGain };
+    }
+
+    void finishBlock() noexcept
+    {
+        if (! blockIsOpen)
+            return;
+
+        abstractFifo.finishedWrite (block1 + block2);
+
+        int headerStart1, headerBlock1, headerStart2, headerBlock2;
+        headerFifo.prepareToWrite (1, headerStart1, headerBlock1, headerStart2, headerBlock2);
+        headers[headerBlock1 > 0 ? headerStart1 : headerStart2] = pendingHeader;
+        headerFifo.finishedWrite (1);
+
+        blockIsOpen = false;
+    }
+
+    //==============================================================================
+    // any thread
+
+    Levels getLevels (const int signal) const noexcept
+    {
+        Levels levels;
+        levels.momentaryLoudness = results[signal][momentary].load (std::memory_order_relaxed);
+        levels.shortTermLoudness = results[signal][shortTerm].load (std::memory_order_relaxed);
+        levels.truePeak = results[signal][truePeak].load (std::memory_order_relaxed);
+        levels.crestFactor = results[signal][crestFactor].load (std::memory_order_relaxed);
+        return levels;
+    }
+
+    /** Number of blocks which didn't fit into the fifo, as the analysis thread couldn't keep up. */
+    int getNumDroppedBlocks() const noexcept { return numDroppedBlocks.load(); }
+
+    // called by the analysis service
+    bool processNextFrame() override
+    {
+        if (headerFifo.getNumReady() < 1)
+            return false;
+
+        int headerStart1, headerBlock1, headerStart2, headerBlock2;
+        headerFifo.prepareToRead (1, headerStart1, headerBlock1, headerStart2, headerBlock2);
+        const auto header = headers[headerBlock1 > 0 ? headerStart1 : headerStart2];
+        headerFifo.finishedRead (1);
+
+        const int numSamples = header.numSamples;
+        int readStart1, readBlock1, readStart2, readBlock2;
+        abstractFifo.prepareToRead (numSignals * header.numGroups * numSamples,
+                                    readStart1, readBlock1, readStart2, readBlock2);
+
+        int subBlockPositionAfter = subBlockPosition;
+        int historyIndexAfter = historyIndex;
+        bool closedSubBlock = false;
+
+        for (int signal = 0; signal < numSignals; ++signal)
+        {
+            auto* weightedSum = scratch.getChannelPointer (weightedSumChannel);
+            auto* energySum = scratch.getChannelPointer (energySumChannel);
+            auto* peakMax = scratch.getChannelPointer (peakMaxChannel);
+            std::fill (weightedSum, weightedSum + numSamples, SampleType (0.0f));
+            std::fill (energySum, energySum + numSamples, SampleType (0.0f));
+            std::fill (peakMax, peakMax + numSamples, SampleType (0.0f));
+
+            if ((header.writtenSignals & (1u << signal)) != 0)
+            {
+                for (int group = 0; group < header.numGroups; ++group)
+                {
+                    auto* x = scratch.getChannelPointer (signalChannel);
+                    readRecord (x, (signal * header.numGroups + group) * numSamples, numSamples,
+                                readStart1, readBlock1, readStart2);
+                    applyGain (x, numSamples, header.gains[signal]);
+                    measureGroup (signal * maxNumGroups + group, x, numSamples, weightedSum, energySum, peakMax);
+                }
+            }
+            else if ((wasWritten & (1u << signal)) != 0)
+                resetSignal (signal); // starts from a cleared state, once it's written again
+
+            // the lanes of all groups are the channels of this signal
+            int position = subBlockPosition;
+            int index = historyIndex;
+            auto& accumulator = accumulators[signal];
+            for (int i = 0; i < numSamples; ++i)
+            {
+                accumulator.weighted += sumOfElements (weightedSum[i]);
+                accumulator.energy += sumOfElements (energySum[i]);
+                accumulator.peak = juce::jmax (accumulator.peak, maxOfElements (peakMax[i]));
+
+                if (++position == subBlockLength)
+                {
+                    auto& history = histories[signal];
+                    history.weighted[index] = accumulator.weighted;
+                    history.energy[index] = accumulator.energy;
+                    history.peak[index] = accumulator.peak;
+                    accumulator = {};
+
+                    position = 0;
+                    index = (index + 1) % numHistorySubBlocks;
+                    closedSubBlock = true;
+                }
+            }
+
+            subBlockPositionAfter = position;
+            historyIndexAfter = index;
+        }
+
+        abstractFifo.finishedRead (readBlock1 + readBlock2);
+
+        wasWritten = header.writtenSignals;
+        subBlockPosition = subBlockPositionAfter;
+        historyIndex = historyIndexAfter;
+
+        if (closedSubBlock)
+            publishResults (juce::jmax (1, header.numChannels));
+
+        return true;
+    }
+
+private:
+    enum ResultIndices { momentary, shortTerm, truePeak, crestFactor, numResults };
+
+    enum ScratchChannels
+    {
+        signalChannel,
+        weightedChannel,
+        interpolatorChannel, // history followed by the signal
+        weightedSumChannel,
+        energySumChannel,
+        peakMaxChannel,
+        numScratchChannels
+    };
+
+    struct GainRamp
+    {
+        float startGain = 1.0f;
+        float gainStep = 0.0f;
+        int numRampSamples = 0;
+        float endGain = 1.0f;
+    };
+
+    struct BlockHeader
+    {
+        int numSamples = 0;
+        int numGroups = 0;
+        int numChannels = 0;
+        juce::uint32 writtenSignals = 0;
+        GainRamp gains[size_t (numSignals)];
+    };
+
+    //==============================================================================
+    // the two biquads of the K-weighting filter, as in the reference implementation of BS.1770
+    static juce::dsp::IIR::Coefficients<float>::Ptr makeShelf (const double fs)
+    {
+        const double f0 = 1681.974450955533;
+        const double G = 3.999843853973347;
+        const double Q = 0.7071752369554196;
+
+        const double K = std::tan (juce::MathConstants<double>::pi * f0 / fs);
+        const double Vh = std::pow (10.0, G / 20.0);
+        const double Vb = std::pow (Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+
+        return new juce::dsp::IIR::Coefficients<float> (float ((Vh + Vb * K / Q + K * K) / a0),
+                                                        float (2.0 * (K * K - Vh) / a0),
+                                                        float ((Vh - Vb * K / Q + K * K) / a0),
+                                                        1.0f,
+                                                        float (2.0 * (K * K - 1.0) / a0),
+                                                        float ((1.0 - K / Q + K * K) / a0));
+    }
+
+    static juce::dsp::IIR::Coefficients<float>::Ptr makeHighPass (const double fs)
+    {
+        const double f0 = 38.13547087602444;
+        const double Q = 0.5003270373238773;
+
+        const double K = std::tan (juce::MathConstants<double>::pi * f0 / fs);
+        const double a0 = 1.0 + K / Q + K * K;
+
+        return new juce::dsp::IIR::Coefficients<float> (1.0f,
+                                                        -2.0f,
+                                                        1.0f,
+                                                        1.0f,
+                                                        float (2.0 * (K * K - 1.0) / a0),
+                                                        float ((1.0 - K / Q + K * K) / a0));
+    }
+
+    // 4x oversampling for the true peak, as a polyphase blackman windowed sinc
+    static constexpr int oversamplingFactor = 4;
+    static constexpr int numPhaseTaps = 12;
+
+    void designInterpolator()
+    {
+        constexpr int numTaps = oversamplingFactor * numPhaseTaps;
+        const float centre = 0.5f * (numTaps - 1);
+
+        for (int phase = 0; phase < oversamplingFactor; ++phase)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < numPhaseTaps; ++k)
+            {
+                const int n = oversamplingFactor * k + phase;
+                const float t = (n - centre) / oversamplingFactor;
+                const float sinc = std::sin (juce::MathConstants<float>::pi * t) / (juce::MathConstants<float>::pi * t);
+                const float window = juce::MathConstants<float>::twoPi * (n + 0.5f) / numTaps;
+                interpolator[phase][k] = sinc * (0.42f - 0.5f * std::cos (window) + 0.08f * std::cos (2.0f * window));
+                sum += interpolator[phase][k];
+            }
+
+            // each phase on its own has unity gain
+            for (int k = 0; k < numPhaseTaps; ++k)
+                interpolator[phase][k] /= sum;
+        }
+    }
+
+    //==============================================================================
+    void reset()
+    {
+        for (int signal = 0; signal < numSignals; ++signal)
+        {
+            resetSignal (signal);
+            histories[signal] = {};
+            accumulators[signal] = {};
+            for (auto& value : results[signal])
+                value = minusInfinityDb;
+        }
+
+        wasWritten = 0;
+        subBlockPosition = 0;
+        historyIndex = 0;
+    }
+
+    void resetSignal (const int signal)
+    {
+        for (int group = 0; group < maxNumGroups; ++group)
+        {
+            const int index = signal * maxNumGroups + group;
+            shelves[index]->reset (SampleType (0.0f));
+            highPasses[index]->reset (SampleType (0.0f));
+
+            auto* history = interpolatorHistory.getChannelPointer (size_t (index));
+            std::fill (history, history + numPhaseTaps, SampleType (0.0f));
+        }
+    }
+
+    void readRecord (SampleType* destination, const int position, const int numSamples,
+                     const int readStart1, const int readBlock1, const int readStart2) const noexcept
+    {
+        const auto* source = fifo.getChannelPointer (0);
+        const int n1 = juce::jlimit (0, numSamples, readBlock1 - position);
+        if (n1 > 0)
+            std::copy (source + readStart1 + position, source + readStart1 + position + n1, destination);
+        if (n1 < numSamples)
+        {
+            const auto* rest = source + readStart2 + juce::jmax (0, position - readBlock1);
+            std::copy (rest, rest + numSamples - n1, destination + n1);
+        }
+    }
+
+    static void applyGain (SampleType* x, const int numSamples, const GainRamp& ramp) noexcept
+    {
+        float gain = ramp.startGain;
+        int i = 0;
+        for (; i < juce::jmin (numSamples, ramp.numRampSamples); ++i)
+        {
+            x[i] = x[i] * gain;
+            gain += ramp.gainStep;
+        }
+
+        if (ramp.endGain != 1.0f)
+            for (; i < numSamples; ++i)
+                x[i] = x[i] * ramp.endGain;
+    }
+
+    // K-weighted and plain energy, and the true peak of one group of channels, added to the per sample sums
+    void measureGroup (const int filterIndex, const SampleType* x, const int numSamples,
+                       SampleType* weightedSum, SampleType* energySum, SampleType* peakMax)
+    {
+        auto* weighted = scratch.getChannelPointer (weightedChannel);
+        const SampleType* input[1] = { x };
+        SampleType* output[1] = { weighted };
+        juce::dsp::AudioBlock<const SampleType> inputBlock (input, 1, size_t (numSamples));
+        juce::dsp::AudioBlock<SampleType> outputBlock (output, 1, size_t (numSamples));
+        shelves[filterIndex]->process (juce::dsp::ProcessContextNonReplacing<SampleType> (inputBlock, outputBlock));
+        highPasses[filterIndex]->process (juce::dsp::ProcessContextReplacing<SampleType> (outputBlock));
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            weightedSum[i] += weighted[i] * weighted[i];
+            energySum[i] += x[i] * x[i];
+        }
+
+        // the interpolator runs over the last numPhaseTaps samples of the previous block and this one
+        auto* history = interpolatorHistory.getChannelPointer (size_t (filterIndex));
+        auto* padded = scratch.getChannelPointer (interpolatorChannel);
+        std::copy (history, history + numPhaseTaps, padded);
+        std::copy (x, x + numSamples, padded + numPhaseTaps);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const SampleType* taps = padded + numPhaseTaps + i;
+            SampleType peak = absMax (peakMax[i], x[i]);
+
+            for (int phase = 0; phase < oversamplingFactor; ++phase)
+            {
+                SampleType y = taps[0] * interpolator[phase][0];
+                for (int k = 1; k < numPhaseTaps; ++k)
+                    y += taps[-k] * interpolator[phase][k];
+                peak = absMax (peak, y);
+            }
+
+            peakMax[i] = peak;
+        }
+
+        std::copy (padded + numSamples, padded + numSamples + numPhaseTaps, history);
+    }
+
+    void publishResults (const int numChannels)
+    {
+        for (int signal = 0; signal < numSignals; ++signal)
+        {
+            const auto& history = histories[signal];
+
+            double momentaryWeighted = 0.0, momentaryEnergy = 0.0, shortTermWeighted = 0.0;
+            float peak = 0.0f;
+            for (int i = 1; i <= numHistorySubBlocks; ++i)
+            {
+                const int index = (historyIndex - i + numHistorySubBlocks) % numHistorySubBlocks;
+                shortTermWeighted += history.weighted[index];
+
+                if (i <= numMomentarySubBlocks)
+                {
+                    momentaryWeighted += history.weighted[index];
+                    momentaryEnergy += history.energy[index];
+                    peak = juce::jmax (peak, history.peak[index]);
+                }
+            }
+
+            // the channels' mean squares are summed for the loudness, and averaged for the crest factor
+            const double momentaryLength = double (numMomentarySubBlocks) * subBlockLength;
+            const double shortTermLength = double (numHistorySubBlocks) * subBlockLength;
+            const double meanSquare = momentaryEnergy / (momentaryLength * numChannels);
+
+            const float truePeakDb = juce::Decibels::gainToDecibels (peak, minusInfinityDb);
+            results[signal][momentary] = toLoudness (momentaryWeighted / momentaryLength);
+            results[signal][shortTerm] = toLoudness (shortTermWeighted / shortTermLength);
+            results[signal][truePeak] = truePeakDb;
+            results[signal][crestFactor] =
+                truePeakDb > minusInfinityDb && meanSquare > 0.0
+                    ? float (10.0 * std::log10 (double (peak) * peak / meanSquare))
+                    : 0.0f;
+        }
+    }
+
+    static float toLoudness (const double sumOfMeanSquares) noexcept
+    {
+        return sumOfMeanSquares > 0.0
+                   ? juce::jmax (minusInfinityDb, float (-0.691 + 10.0 * std::log10 (sumOfMeanSquares)))
+                   : minusInfinityDb;
+    }
+
+#if JUCE_USE_SIMD
+    static juce::dsp::SIMDRegister<float> absMax (juce::dsp::SIMDRegister<float> a, juce::dsp::SIMDRegister<float> b) noexcept
+    {
+        return juce::dsp::SIMDRegister<float>::max (a, juce::dsp::SIMDRegister<float>::abs (b));
+    }
+
+    static float sumOfElements (juce::dsp::SIMDRegister<float> a) noexcept { return a.sum(); }
+
+    static float maxOfElements (juce::dsp::SIMDRegister<float> a) noexcept
+    {
+        float maximum = a.get (0);
+        for (size_t i = 1; i < juce::dsp::SIMDRegister<float>::size(); ++i)
+            maximum = juce::jmax (maximum, a.get (i));
+        return maximum;
+    }
+#endif
+
+    static float absMax (const float a, const float b) noexcept { return juce::jmax (a, std::abs (b)); }
+    static float sumOfElements (const float a) noexcept { return a; }
+    static float maxOfElements (const float a) noexcept { return a; }
+
+    //==============================================================================
+    juce::SharedResourcePointer<AnalysisService> service;
+
+    double sampleRate = 48000.0;
+    int maxBlockSize = 0;
+    int maxNumGroups = 0;
+
+    // audio thread to analysis thread
+    juce::HeapBlock<char> fifoData;
+    juce::dsp::AudioBlock<SampleType> fifo;
+    juce::AbstractFifo abstractFifo { 1 };
+    static constexpr int numHeaders = 64;
+    BlockHeader headers[numHeaders];
+    juce::AbstractFifo headerFifo { numHeaders };
+    std::atomic<int> numDroppedBlocks { 0 };
+
+    // audio thread only
+    BlockHeader pendingHeader;
+    bool blockIsOpen = false;
+    int start1 = 0, block1 = 0, start2 = 0, block2 = 0;
+
+    // analysis thread only
+    juce::HeapBlock<char> scratchData;
+    juce::dsp::AudioBlock<SampleType> scratch;
+    juce::OwnedArray<juce::dsp::IIR::Filter<SampleType>> shelves, highPasses; // numSignals * maxNumGroups
+    float interpolator[oversamplingFactor][numPhaseTaps];
+    juce::HeapBlock<char> interpolatorHistoryData;
+    juce::dsp::AudioBlock<SampleType> interpolatorHistory;
+    juce::uint32 wasWritten = 0;
+
+    // 100 ms sub-blocks, momentary loudness over 4 of them, short-term over all 30
+    static constexpr int numMomentarySubBlocks = 4;
+    static constexpr int numHistorySubBlocks = 30;
+    int subBlockLength = 4800;
+    int subBlockPosition = 0;
+    int historyIndex = 0; // next sub-block to be written
+
+    struct Accumulator
+    {
+        double weighted = 0.0; // summed over the channels
+        double energy = 0.0;
+        float peak = 0.0f;
+    };
+
+    struct History
+    {
+        double weighted[numHistorySubBlocks] = {};
+        double energy[numHistorySubBlocks] = {};
+        float peak[numHistorySubBlocks] = {};
+    };
+
+    Accumulator accumulators[size_t (numSignals)];
+    History histories[size_t (numSignals)];
+
+    std::atomic<float> results[size_t (numSignals)][numResults];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+};
@@ -0,0 +1,172 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/* Peak and RMS levels of the input, the output and every band, per channel.
+
+ The audio thread accumulates the levels of its blocks and publishes them as
+ one frame per block through a triple buffer. The measurement window only
+ restarts once a frame has been picked up (or after maxWindowLength samples),
+ so no peak between two GUI frames gets lost. */
+
+template <int numBands, int maxChannels>
+class MeterTelemetry
+{
+public:
+    enum Sources
+    {
+        input,
+        output,
+        firstBand,
+        numSources = firstBand + numBands
+    };
+
+    struct Frame
+    {
+        float peak[numSources][size_t (maxChannels)]; // linear
+        float rms[numSources][size_t (maxChannels)]; // linear
+        int numChannels = 0;
+        int numSamples = 0; // length of the measurement window
+
+        float getMaxPeak (const int source) const noexcept
+        {
+            return numChannels > 0 ? juce::FloatVectorOperations::findMaximum (peak[source], numChannels)
+                                   : 0.0f;
+        }
+
+        float getMaxRms (const int source) const noexcept
+        {
+            return numChannels > 0 ? juce::FloatVectorOperations::findMaximum (rms[source], numChannels)
+                                   : 0.0f;
+        }
+    };
+
+    MeterTelemetry()
+    {
+        for (auto& frame : frames)
+            clearFrame (frame);
+        resetWindow (0);
+    }
+
+    /** Longest measurement window, should be set in prepareToPlay(). */
+    void setMaxWindowLength (const int numSamples) { maxWindowLength = juce::jmax (1, numSamples); }
+
+    //==============================================================================
+    // audio thread
+
+    /** Restarts the measurement window, if the last frame was picked up. */
+    void beginBlock (const int numChannels) noexcept
+    {
+        jassert (numChannels <= maxChannels);
+
+        if (windowConsumed.exchange (false) || windowLength >= maxWindowLength
+            || numChannels != windowChannels)
+            resetWindow (juce::jmin (numChannels, maxChannels));
+    }
+
+    void addLevels (const int source, const int channel, const float peak, const float sumOfSquares) noexcept
+    {
+        if (channel >= windowChannels)
+            return;
+
+        peaks[source][channel] = juce::jmax (peaks[source][channel], peak);
+        energies[source][channel] += sumOfSquares;
+    }
+
+    void publish (const int numSamples) noexcept
+    {
+        windowLength += numSamples;
+
+        auto& frame = frames[backFrame];
+        frame.numChannels = windowChannels;
+        frame.numSamples = windowLength;
+
+        const double meanScale = windowLength > 0 ? 1.0 / windowLength : 0.0;
+        for (int source = 0; source < numSources; ++source)
+        {
+            for (int channel = 0; channel < windowChannels; ++channel)
+            {
+                frame.peak[source][channel] = peaks[source][channel];
+                frame.rms[source][channel] =
+                    static_cast<float> (std::sqrt (energies[source][channel] * meanScale));
+            }
+        }
+
+        backFrame = publishedFrame.exchange (backFrame | freshFrameFlag) & frameIndexMask;
+    }
+
+    //==============================================================================
+    // message thread
+
+    bool hasNewFrame() const noexcept { return (publishedFrame.load() & freshFrameFlag) != 0; }
+
+    /** The most recent frame, valid until the next call. */
+    const Frame& acquireLatestFrame() noexcept
+    {
+        if (publishedFrame.load() & freshFrameFlag)
+        {
+            frontFrame = publishedFrame.exchange (frontFrame) & frameIndexMask;
+            windowConsumed = true;
+        }
+
+        return frames[frontFrame];
+    }
+
+private:
+    static void clearFrame (Frame& frame)
+    {
+        for (int source = 0; source < numSources; ++source)
+        {
+            juce::FloatVectorOperations::clear (frame.peak[source], maxChannels);
+            juce::FloatVectorOperations::clear (frame.rms[source], maxChannels);
+        }
+    }
+
+    void resetWindow (const int numChannels) noexcept
+    {
+        for (int source = 0; source < numSources; ++source)
+        {
+            juce::FloatVectorOperations::clear (peaks[source], maxChannels);
+            juce::FloatVectorOperations::clear (energies[source], maxChannels);
+        }
+
+        windowChannels = numChannels;
+        windowLength = 0;
+    }
+
+    // accumulated since the window was restarted, audio thread only
+    float peaks[numSources][size_t (maxChannels)];
+    double energies[numSources][size_t (maxChannels)];
+    int windowChannels = 0;
+    int windowLength = 0;
+    int maxWindowLength = 48000;
+
+    // triple buffer, see Analyser
+    enum { frameIndexMask = 3, freshFrameFlag = 4 };
+    Frame frames[3];
+    int backFrame = 0, frontFrame = 2;
+    std::atomic<int> publishedFrame { 1 };
+    std::atomic<bool> windowConsumed { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterTelemetry)
+};
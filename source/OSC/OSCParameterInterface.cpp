@@ -49,7 +49,13 @@ OSCParameterInterface::OSCParameterInterface (OSCMessageInterceptor& i,
 
     oscReceiver.addListener (this);
 
-    startTimer (100);
+    // remote receivers expect the configured rate, so the sender doesn't back off when idle
+    frameScheduler->addClient (this, 100, 0);
+}
+
+OSCParameterInterface::~OSCParameterInterface()
+{
+    frameScheduler->removeClient (this);
 }
 
 std::unique_ptr<juce::RangedAudioParameter> OSCParameterInterface::createParameterTheOldWay (
@@ -193,15 +199,17 @@ void OSCParameterInterface::oscBundleReceived (const juce::OSCBundle& bundle)
     }
 }
 
-void OSCParameterInterface::timerCallback()
+bool OSCParameterInterface::frameCallback()
 {
-    sendParameterChanges();
+    return sendParameterChanges();
 }
 
-void OSCParameterInterface::sendParameterChanges (const bool forceSend)
+bool OSCParameterInterface::sendParameterChanges (const bool forceSend)
 {
     if (! oscSender.isConnected())
-        return;
+        return false;
+
+    bool sentAnything = false;
 
     auto& params = parameters.processor.getParameters();
     const int nParams = params.size();
@@ -216,6 +224,7 @@ void OSCParameterInterface::sendParameterChanges (const bool forceSend)
             if (forceSend || lastSentValues[i] != normValue)
             {
                 lastSentValues.set (i, normValue);
+                sentAnything = true;
 
                 const auto paramID = ptr->paramID;
                 auto range (parameters.getParameterRange (paramID));
@@ -233,11 +242,12 @@ void OSCParameterInterface::sendParameterChanges (const bool forceSend)
     }
 
     interceptor.sendAdditionalOSCMessages (oscSender, address);
+    return sentAnything;
 }
 
 void OSCParameterInterface::setInterval (const int interValInMilliseconds)
 {
-    startTimer (juce::jlimit (1, 1000, interValInMilliseconds));
+    frameScheduler->setInterval (this, juce::jlimit (1, 1000, interValInMilliseconds));
 }
 
 void OSCParameterInterface::setOSCAddress (juce::String newAddress)
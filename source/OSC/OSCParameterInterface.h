@@ -23,6 +23,7 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
 
+#include "../FrameScheduler.h"
 #include "OSCUtilities.h"
 
 #if defined(_MSC_VER)
@@ -38,11 +39,12 @@ typedef SSIZE_T ssize_t;
 
 class OSCParameterInterface
     : public juce::OSCReceiver::Listener<juce::OSCReceiver::RealtimeCallback>,
-      private juce::Timer
+      private FrameScheduler::Client
 {
 public:
     OSCParameterInterface (OSCMessageInterceptor& interceptor,
                            juce::AudioProcessorValueTreeState& valueTreeState);
+    ~OSCParameterInterface() override;
 
     static std::unique_ptr<juce::RangedAudioParameter> createParameterTheOldWay (
         const juce::String& parameterID,
@@ -75,15 +77,16 @@ public:
     void oscMessageReceived (const juce::OSCMessage& message) override;
     void oscBundleReceived (const juce::OSCBundle& bundle) override;
 
-    void timerCallback() override;
+    bool frameCallback() override;
 
-    void sendParameterChanges (bool forceSend = false);
+    /** Returns true if any parameter was sent. */
+    bool sendParameterChanges (bool forceSend = false);
     void setOSCAddress (juce::String newAddress);
 
     juce::String getOSCAddress() const { return address; }
 
     void setInterval (int interValInMilliseconds);
-    int getInterval() const { return getTimerInterval(); }
+    int getInterval() const { return frameScheduler->getInterval (this); }
 
     juce::ValueTree getConfig() const;
     void setConfig (juce::ValueTree config);
@@ -97,4 +100,6 @@ private:
 
     juce::String address;
     juce::Array<float> lastSentValues;
+
+    juce::SharedResourcePointer<FrameScheduler> frameScheduler;
 };
@@ -113,11 +113,18 @@ OSCDialogWindow::OSCDialogWindow (OSCParameterInterface& oscInterface,
     addAndMakeVisible (slInterval);
     slInterval.setText ("Interval");
 
-    startTimer (500);
+    frameScheduler->addClient (this, 500, 1000);
 }
 
-void OSCDialogWindow::timerCallback()
+OSCDialogWindow::~OSCDialogWindow()
 {
+    frameScheduler->removeClient (this);
+}
+
+bool OSCDialogWindow::frameCallback()
+{
+    bool hasChanged = false;
+
     bool shouldReceiverBeConnected = receiver.isConnected();
     if (isReceiverConnected != shouldReceiverBeConnected)
     {
@@ -127,6 +134,7 @@ void OSCDialogWindow::timerCallback()
                                   isReceiverConnected ? juce::Colours::orangered
                                                       : juce::Colours::limegreen);
         repaint();
+        hasChanged = true;
     }
 
     bool shouldSenderBeConnected = sender.isConnected();
@@ -138,7 +146,10 @@ void OSCDialogWindow::timerCallback()
                                 isSenderConnected ? juce::Colours::orangered
                                                   : juce::Colours::limegreen);
         repaint();
+        hasChanged = true;
     }
+
+    return hasChanged;
 }
 
 void OSCDialogWindow::updateOSCAddress()
@@ -307,11 +318,18 @@ OSCStatus::OSCStatus (OSCParameterInterface& oscInterface) :
     oscSender (oscInterface.getOSCSender())
 {
     isReceiverOpen = oscReceiver.isConnected();
-    startTimer (500);
+    frameScheduler->addClient (this, 500, 1000);
 }
 
-void OSCStatus::timerCallback()
+OSCStatus::~OSCStatus()
 {
+    frameScheduler->removeClient (this);
+}
+
+bool OSCStatus::frameCallback()
+{
+    bool hasChanged = false;
+
     const int receiverPort = oscReceiver.getPortNumber();
     const int senderPort = oscSender.getPortNumber();
     const juce::String senderHostName = oscSender.getHostName();
@@ -324,6 +342,7 @@ void OSCStatus::timerCallback()
         lastReceiverPort = receiverPort;
         isReceiverOpen = shouldReceiverBeConnected;
         repaint();
+        hasChanged = true;
     }
 
     if (isSenderOpen != shouldSenderBeConnected || lastSenderPort != senderPort
@@ -333,7 +352,10 @@ void OSCStatus::timerCallback()
         lastSenderHostName = senderHostName;
         isSenderOpen = shouldSenderBeConnected;
         repaint();
+        hasChanged = true;
     }
+
+    return hasChanged;
 }
 
 void OSCStatus::mouseMove (const juce::MouseEvent& event)
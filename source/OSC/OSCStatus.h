@@ -25,14 +25,17 @@
 #include "../Components/SimpleLabel.h"
 #include "OSCParameterInterface.h"
 
-class OSCDialogWindow : public juce::Component, private juce::Timer, private juce::Label::Listener
+class OSCDialogWindow : public juce::Component,
+                        private FrameScheduler::Client,
+                        private juce::Label::Listener
 {
 public:
     OSCDialogWindow (OSCParameterInterface& oscInterface,
                      OSCReceiverPlus& oscReceiver,
                      OSCSenderPlus& oscSender);
+    ~OSCDialogWindow() override;
 
-    void timerCallback() override;
+    bool frameCallback() override;
 
     void updateOSCAddress();
 
@@ -60,18 +63,21 @@ private:
 
     juce::Slider intervalSlider;
     juce::TextButton tbReceiverOpen, tbSenderOpen, tbFlush;
+
+    juce::SharedResourcePointer<FrameScheduler> frameScheduler;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OSCDialogWindow)
 };
 
 //==============================================================================
 /*
  */
-class OSCStatus : public juce::Component, private juce::Timer
+class OSCStatus : public juce::Component, private FrameScheduler::Client
 {
 public:
     OSCStatus (OSCParameterInterface& oscInterface);
+    ~OSCStatus() override;
 
-    void timerCallback() override;
+    bool frameCallback() override;
 
     void mouseMove (const juce::MouseEvent& event) override;
 
@@ -96,5 +102,7 @@ private:
     int lastSenderPort = -1;
     juce::String lastSenderHostName;
 
+    juce::SharedResourcePointer<FrameScheduler> frameScheduler;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OSCStatus)
 };
@@ -30,12 +30,14 @@ MultiBandCompressorAudioProcessorEditor::MultiBandCompressorAudioProcessorEditor
     processor (p),
     valueTreeState (vts),
     footer (p.getOSCParameterInterface()),
-    filterBankVisualizer (20.0f, 20000.0f, -15.0f, 20.0f, 5.0f, p.getSampleRate(), numFilterBands)
+    filterBankVisualizer (20.0f, 20000.0f, -15.0f, 20.0f, 5.0f, p.getSampleRate(), numFilterBands),
+    loadDisplay (p.loadMeter)
 {
     // ============== BEGIN: essentials ======================
     // set GUI size and lookAndFeel
     setResizeLimits (980, 980 * 0.6, 1600, 1600 * 0.6); // use this to create a resizable GUI
     setLookAndFeel (&globalLaF);
+    setOpaque (true);
 
     // make title and footer visible, and set the PluginName
     addAndMakeVisible (&title);
@@ -146,6 +148,13 @@ MultiBandCompressorAudioProcessorEditor::MultiBandCompressorAudioProcessorEditor
 
     addAndMakeVisible (&filterBankVisualizer);
 
+    // analyser traces, only their dirty areas are repainted
+    inputTrace = filterBankVisualizer.getAnalyserOverlay().addTrace (juce::Colours::greenyellow);
+    outputTrace = filterBankVisualizer.getAnalyserOverlay().addTrace (juce::Colours::indianred);
+
+    addAndMakeVisible (&waterfall);
+    addAndMakeVisible (&loadDisplay);
+
     // SHOW OVERALL MAGNITUDE BUTTON
     tbOverallMagnitude.setColour (juce::ToggleButton::tickColourId, juce::Colours::white);
     tbOverallMagnitude.setButtonText ("show total magnitude");
@@ -195,31 +204,41 @@ MultiBandCompressorAudioProcessorEditor::MultiBandCompressorAudioProcessorEditor
     It seems resized() somehow gets called *before* the constructor and therefore juce::OwnedArray<CompressorVisualizers> is still empty on the first resized call... */
     resized();
 
-    // start timer after everything is set up properly
-    startTimer (50);
+    for (int i = 0; i < numFilterBands; ++i)
+    {
+        if (i < numFilterBands - 1)
+            filterParameters[i] = valueTreeState.getRawParameterValue ("crossover" + juce::String (i));
+        filterParameters[numFilterBands - 1 + i] = valueTreeState.getRawParameterValue ("gain" + juce::String (i));
+    }
+    for (auto& value : drawnFilterParameters)
+        value = std::numeric_limits<float>::quiet_NaN(); // drawn with the first frame
+
+    // start frames after everything is set up properly
+    processor.frameScheduler->addClient (this, 50);
 }
 
 MultiBandCompressorAudioProcessorEditor::~MultiBandCompressorAudioProcessorEditor()
 {
+    processor.frameScheduler->removeClient (this);
+    processor.setEditorVisible (false);
+    processor.outputAnalyser.setPixelHistory (0, 20.0f);
     setLookAndFeel (nullptr);
 }
 
+void MultiBandCompressorAudioProcessorEditor::visibilityChanged()
+{
+    processor.setEditorVisible (isShowing());
+}
+
+void MultiBandCompressorAudioProcessorEditor::parentHierarchyChanged()
+{
+    processor.setEditorVisible (isShowing());
+}
+
 //==============================================================================
 void MultiBandCompressorAudioProcessorEditor::paint (juce::Graphics& g)
 {
     g.fillAll (globalLaF.ClBackground);
-
-    // Draw the input analyzer
-    juce::Path inputPath;
-    processor.inputAnalyser.createPath(inputPath, filterBankVisualizer.getBounds().toFloat().reduced(30,10), 20.0f);
-    g.setColour(juce::Colours::greenyellow);
-    g.strokePath(inputPath, juce::PathStrokeType(1.0f));
-
-    // Draw the output analyzer
-    juce::Path outputPath;
-    processor.outputAnalyser.createPath(outputPath, filterBankVisualizer.getBounds().toFloat().reduced(30,10), 20.0f);
-    g.setColour(juce::Colours::indianred);
-    g.strokePath(outputPath, juce::PathStrokeType(1.0f));
 }
 
 void MultiBandCompressorAudioProcessorEditor::resized()
@@ -324,6 +343,13 @@ void MultiBandCompressorAudioProcessorEditor::resized()
     compressorArea.reduce (
         ((compressorArea.getWidth() - (numFilterBands - 1) * bandToBandGap) % numFilterBands) / 2,
         0);
+
+    // the waterfall spans the rows below the band gains
+    juce::Rectangle<int> waterfallArea = compressorArea.withTop (
+        compressorArea.getBottom() - compressorArea.proportionOfHeight (paramToCharacteristiscRatio));
+    waterfallArea.removeFromTop (paramToCharacteristicGap / 2);
+    waterfall.setBounds (waterfallArea);
+    processor.outputAnalyser.setPixelHistory (waterfall.getNumRows(), 20.0f);
     const int widthPerBand =
         ((compressorArea.getWidth() - (numFilterBands - 1) * bandToBandGap) / numFilterBands);
     juce::Rectangle<int> characteristicArea, paramArea, paramRow1, paramRow2, labelRow1, labelRow2,
@@ -394,6 +420,9 @@ void MultiBandCompressorAudioProcessorEditor::resized()
     masterArea.removeFromLeft (masterToCompressorSectionGap);
     masterArea.removeFromTop (trimFromGroupComponentHeader);
 
+    // ==== DSP LOAD ====
+    loadDisplay.setBounds (masterArea.removeFromBottom (juce::jmin (masterArea.getHeight(), 70)));
+
     juce::Rectangle<int> sliderRow =
         masterArea.removeFromTop (masterArea.proportionOfHeight (0.5f));
     sliderRow.reduce (sliderRow.proportionOfWidth (trimSliderWidth), sliderRow.proportionOfHeight (trimSliderHeight));
@@ -421,6 +450,8 @@ void MultiBandCompressorAudioProcessorEditor::resized()
 
 void MultiBandCompressorAudioProcessorEditor::sliderValueChanged (juce::Slider* slider)
 {
+    processor.frameScheduler->requestFrame (this);
+
     if (slider->getName().startsWith ("gain"))
     {
         filterBankVisualizer.updateMakeUpGain (
@@ -432,6 +463,8 @@ void MultiBandCompressorAudioProcessorEditor::sliderValueChanged (juce::Slider*
 
 void MultiBandCompressorAudioProcessorEditor::buttonClicked (juce::Button* button)
 {
+    processor.frameScheduler->requestFrame (this);
+
     if (button->getName().startsWith ("kill"))
     {
         int i = button->getName().getLastCharacters (1).getIntValue();
@@ -452,20 +485,69 @@ void MultiBandCompressorAudioProcessorEditor::buttonClicked (juce::Button* butto
     }
 }
 
-void MultiBandCompressorAudioProcessorEditor::timerCallback()
+bool MultiBandCompressorAudioProcessorEditor::frameCallback()
 {
     // === update titleBar widgets according to available input/output channel counts
     // title.setMaxSize (processor.getMaxSize());
     // ==========================================
 
-    if (processor.repaintFilterVisualization.get())
+    bool hasChanged = false;
+
+#if MOSES_STAGE_PROFILING
+    const auto now = juce::Time::getMillisecondCounter();
+    if (now - lastStageProfileUpdate >= 1000)
+    {
+        lastStageProfileUpdate = now;
+        showStageProfile();
+        hasChanged = true;
+    }
+#endif
+
+    bool filterParametersChanged = processor.repaintFilterVisualization.get();
+    for (int i = 0; i < 2 * numFilterBands - 1; ++i)
+    {
+        const float value = filterParameters[i]->load();
+        if (value != drawnFilterParameters[i])
+        {
+            drawnFilterParameters[i] = value;
+            filterParametersChanged = true;
+        }
+    }
+
+    if (filterParametersChanged)
     {
         processor.repaintFilterVisualization = false;
+        processor.updateFilterVisualizationCoefficients();
         filterBankVisualizer.updateFreqBandResponses();
+        hasChanged = true;
     }
 
-    omniInputMeter.setLevel (processor.inputPeak.get());
-    omniOutputMeter.setLevel (processor.outputPeak.get());
+    using Meters = MultiBandCompressorAudioProcessor::Meters;
+    const auto& meters = processor.meterTelemetry.acquireLatestFrame();
+
+    auto showLevels = [&meters] (LevelMeter& meter, const int source)
+    {
+        const bool peakMoved = meter.setLevel (juce::Decibels::gainToDecibels (meters.getMaxPeak (source)));
+        const bool rmsMoved = meter.setRms (juce::Decibels::gainToDecibels (meters.getMaxRms (source)));
+        return peakMoved || rmsMoved;
+    };
+
+    hasChanged |= showLevels (omniInputMeter, Meters::input);
+    hasChanged |= showLevels (omniOutputMeter, Meters::output);
+
+    auto showLoudness = [this] (LevelMeter& meter, const int source)
+    {
+        const auto levels = processor.loudnessMeter.getLevels (source);
+        return meter.setLoudness (levels.momentaryLoudness,
+                                  levels.shortTermLoudness,
+                                  levels.truePeak,
+                                  levels.crestFactor);
+    };
+
+    hasChanged |= showLoudness (omniInputMeter, Meters::input);
+    hasChanged |= showLoudness (omniOutputMeter, Meters::output);
+    hasChanged |= loadDisplay.update();
+    loadDisplay.setNumDroppedAnalyserBlocks (processor.getNumDroppedAnalyserBlocks());
 
     for (int i = 0; i < numFilterBands; ++i)
     {
@@ -477,15 +559,75 @@ void MultiBandCompressorAudioProcessorEditor::timerCallback()
         {
             processor.characteristicHasChanged[i] = false;
         }
-        bandLevelMeters[i].setLevel(processor.maxPeak[i].get());
+        hasChanged |= showLevels (bandLevelMeters[i], Meters::firstBand + i);
+        hasChanged |= showLoudness (bandLevelMeters[i], Meters::firstBand + i);
     }
 
     if (displayOverallMagnitude)
         filterBankVisualizer.updateOverallMagnitude();
 
 
-    if (processor.inputAnalyser.checkForNewData() || processor.outputAnalyser.checkForNewData())
+    auto& overlay = filterBankVisualizer.getAnalyserOverlay();
+    const auto analyserArea = overlay.getLocalBounds().toFloat().reduced (30, 10);
+
+    if (processor.inputAnalyser.checkForNewData())
+        hasChanged |= overlay.updateTrace (inputTrace, [&] (juce::Path& p)
+                                           { processor.inputAnalyser.createPath (p, analyserArea, 20.0f); });
+
+    if (processor.outputAnalyser.checkForNewData())
+        hasChanged |= overlay.updateTrace (outputTrace, [&] (juce::Path& p)
+                                           { processor.outputAnalyser.createPath (p, analyserArea, 20.0f); });
+
+    // one column per analyser frame, however many piled up since the last gui frame
+    while (waterfall.addColumn ([&] (float* levels, int numRows)
+                                { return processor.outputAnalyser.popPixelLevels (levels, numRows); }))
+        hasChanged = true;
+
+    if (processor.bandAnalyser.checkForNewData())
     {
-        repaint();
+        const auto spectrumArea = filterBankVisualizer.getSpectrumArea();
+        for (int i = 0; i < numFilterBands; ++i)
+            hasChanged |= filterBankVisualizer.updateBandSpectrum (i, [&] (juce::Path& p)
+                                                                   { processor.bandAnalyser.createPath (p, spectrumArea, 20.0f, i); });
     }
+
+    return hasChanged;
+}
+
+#if MOSES_STAGE_PROFILING
+void MultiBandCompressorAudioProcessorEditor::showStageProfile()
+{
+    // the stage taking the most time next to the name, all of them in the title's tooltip
+    const juce::String microseconds (juce::CharPointer_UTF8 (" \xc2\xb5s"));
+    juce::String table ("mean / p99 / max per block, share");
+    int heaviestStage = -1;
+    double heaviestShare = 0.0;
+
+    for (int stage = 0; stage < MultiBandCompressorAudioProcessor::numProfiledStages; ++stage)
+    {
+        const auto statistics = processor.stageProfiler.getStatistics (stage);
+        if (statistics.numBlocks == 0)
+            continue;
+
+        table << "\n" << MultiBandCompressorAudioProcessor::getProfiledStageName (stage) << ": "
+              << juce::String (statistics.mean, 1) << " / " << juce::String (statistics.p99, 1) << " / "
+              << juce::String (statistics.max, 1) << microseconds << ", "
+              << juce::roundToInt (100.0 * statistics.share) << " %";
+
+        if (statistics.share > heaviestShare)
+        {
+            heaviestShare = statistics.share;
+            heaviestStage = stage;
+        }
+    }
+
+    // the separator starts with a no-break space, the title trims ordinary ones
+    const juce::String separator (juce::CharPointer_UTF8 ("\xc2\xa0\xe2\x80\x93 "));
+    title.setTitle ("Moses",
+                    heaviestStage < 0 ? juce::String()
+                                      : separator + MultiBandCompressorAudioProcessor::getProfiledStageName (heaviestStage)
+                                            + " " + juce::String (juce::roundToInt (100.0 * heaviestShare)) + " %");
+    title.setTooltip (table);
+    title.repaint();
 }
+#endif
@@ -35,6 +35,8 @@
 #include "Components/RoundButton.h"
 #include "Components/SimpleLabel.h"
 #include "FilterBankVisualizer.h"
+#include "LoadDisplay.h"
+#include "WaterfallDisplay.h"
 
 using SliderAttachment = ReverseSlider::
     SliderAttachment; // all ReverseSliders will make use of the parameters' valueToText() function
@@ -45,7 +47,7 @@ using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
 /**
 */
 class MultiBandCompressorAudioProcessorEditor : public juce::AudioProcessorEditor,
-                                                private juce::Timer,
+                                                private FrameScheduler::Client,
                                                 public juce::Slider::Listener,
                                                 public juce::Button::Listener
 {
@@ -57,13 +59,21 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
 
     void sliderValueChanged (juce::Slider* slider) override;
     void buttonClicked (juce::Button* bypassButton) override;
 
-    void timerCallback() override;
-
 private:
+    bool frameCallback() override;
+    friend struct EditorRenderBenchmark; // calls frameCallback() without the scheduler's timer
+
+#if MOSES_STAGE_PROFILING
+    void showStageProfile();
+    juce::uint32 lastStageProfileUpdate = 0;
+#endif
+
     // ====================== begin essentials ==================
     // lookAndFeel class with the IEM plug-in suite design
     LaF globalLaF;
@@ -87,6 +97,12 @@ private:
     std::unique_ptr<ComboBoxAttachment> cbOrderAtachement;
 
     FilterBankVisualizer<double> filterBankVisualizer;
+    // crossovers and gains as last drawn, compared every frame so changes from OSC or automation show too
+    std::atomic<float>* filterParameters[2 * numFilterBands - 1];
+    float drawnFilterParameters[2 * numFilterBands - 1];
+    int inputTrace, outputTrace;
+    WaterfallDisplay waterfall; // of the output
+    LoadDisplay loadDisplay;
     juce::TooltipWindow tooltips;
 
     // Filter Crossovers
@@ -22,8 +22,28 @@
 
 #include "PluginProcessor.h"
 
-#include "FilterVisualizerHelper.h"
-#include "PluginEditor.h"
+#if ! MOSES_HEADLESS
+    #include "FilterVisualizerHelper.h"
+    #include "PluginEditor.h"
+#endif
+
+#if MOSES_STAGE_PROFILING
+    #define MOSES_PROFILE_LAP(stage) stageProfiler.lap (stage)
+#else
+    #define MOSES_PROFILE_LAP(stage)
+#endif
+
+// bands fed by each filter stage, see the block diagram in processBlock
+const int MultiBandCompressorAudioProcessor::stageBandMasks[numFilterStages] = {
+    (1 << Low) | (1 << MidLow) | (1 << Mid), // LP1, LP1 and AP2
+    (1 << MidHigh) | (1 << High), // HP1, HP1 and AP0
+    (1 << MidLow) | (1 << Mid), // HP0
+    (1 << Low), // LP0
+    (1 << Mid), // LP2
+    0, // HP2, its output gets overwritten by LP3 before the summation
+    (1 << MidHigh), // LP3
+    (1 << High) // HP3
+};
 
 //==============================================================================
 MultiBandCompressorAudioProcessor::MultiBandCompressorAudioProcessor() :
@@ -32,40 +52,51 @@ MultiBandCompressorAudioProcessor::MultiBandCompressorAudioProcessor() :
         BusesProperties()
     #if ! JucePlugin_IsMidiEffect
         #if ! JucePlugin_IsSynth
-            .withInput ("Input", juce::AudioChannelSet::discreteChannels (64), true)
+            .withInput ("Input", juce::AudioChannelSet::discreteChannels (maxNumChannels), true)
         #endif
-            .withOutput ("Output", juce::AudioChannelSet::discreteChannels (64), true)
+            .withOutput ("Output", juce::AudioChannelSet::discreteChannels (maxNumChannels), true)
     #endif
             ,
 #endif
         createParameterLayout()),
-    maxNumFilters (ceil (64 / IIRfloat_elements))
+    maxNumFilters (ceil (maxNumChannels / IIRfloat_elements))
 {
-    const juce::String inputSettingID = "orderSetting";
-    orderSetting = parameters.getRawParameterValue (inputSettingID);
-    parameters.addParameterListener (inputSettingID, this);
+    orderSetting = parameters.getRawParameterValue ("orderSetting");
 
-    for (int filterBandIdx = 0; filterBandIdx < numFilterBands - 1; ++filterBandIdx)
+    // the audio thread reads its parameters through this table, see updateParameterSnapshot()
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
     {
-        const juce::String crossoverID ("crossover" + juce::String (filterBandIdx));
+        const juce::String band (filterBandIdx);
+        if (filterBandIdx < numFilterBands - 1)
+            dspParameters[firstCrossoverParameter + filterBandIdx] =
+                parameters.getRawParameterValue ("crossover" + band);
+        dspParameters[firstGainParameter + filterBandIdx] =
+            parameters.getRawParameterValue ("gain" + band);
+        dspParameters[firstSoloParameter + filterBandIdx] =
+            parameters.getRawParameterValue ("solo" + band);
+        dspParameters[firstKillParameter + filterBandIdx] =
+            parameters.getRawParameterValue ("kill" + band);
+    }
 
-        crossovers[filterBandIdx] = parameters.getRawParameterValue (crossoverID);
+    invalidateParameterSnapshot();
+
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands - 1; ++filterBandIdx)
+    {
+        const float crossover = dspParameters[firstCrossoverParameter + filterBandIdx]->load();
 
+#if ! MOSES_HEADLESS
         lowPassLRCoeffs[filterBandIdx] =
-            IIR::Coefficients<double>::makeLowPass (lastSampleRate, *crossovers[filterBandIdx]);
+            IIR::Coefficients<double>::makeLowPass (lastSampleRate, crossover);
         highPassLRCoeffs[filterBandIdx] =
-            IIR::Coefficients<double>::makeHighPass (lastSampleRate, *crossovers[filterBandIdx]);
-
-        calculateCoefficients (filterBandIdx);
+            IIR::Coefficients<double>::makeHighPass (lastSampleRate, crossover);
+#endif
 
         iirLPCoefficients[filterBandIdx] =
-            IIR::Coefficients<float>::makeLowPass (lastSampleRate, *crossovers[filterBandIdx]);
+            IIR::Coefficients<float>::makeLowPass (lastSampleRate, crossover);
         iirHPCoefficients[filterBandIdx] =
-            IIR::Coefficients<float>::makeHighPass (lastSampleRate, *crossovers[filterBandIdx]);
+            IIR::Coefficients<float>::makeHighPass (lastSampleRate, crossover);
         iirAPCoefficients[filterBandIdx] =
-            IIR::Coefficients<float>::makeAllPass (lastSampleRate, *crossovers[filterBandIdx]);
-
-        parameters.addParameterListener (crossoverID, this);
+            IIR::Coefficients<float>::makeAllPass (lastSampleRate, crossover);
 
         iirLP[filterBandIdx].clear();
         iirLP2[filterBandIdx].clear();
@@ -92,22 +123,17 @@ MultiBandCompressorAudioProcessor::MultiBandCompressorAudioProcessor() :
         {
             freqBandsBlocks[filterBandIdx].push_back (juce::HeapBlock<char>());
         }
-
-        const juce::String soloID ("solo" + juce::String (filterBandIdx));
-        const juce::String killID ("kill" + juce::String (filterBandIdx));
-        const juce::String gainID ("gain" + juce::String (filterBandIdx));
-
-        gain[filterBandIdx] = parameters.getRawParameterValue(gainID);
-
-        parameters.addParameterListener (soloID, this);
-        parameters.addParameterListener (killID, this);
-        parameters.addParameterListener(gainID, this);
     }
 
-    soloArray.clear();
-    killArray.clear();
+    for (int stage = 0; stage < numFilterStages; ++stage)
+        stageWasProcessed[stage] = true;
+
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
+        bandGainRamps[filterBandIdx] = {};
 
-    copyCoeffsToProcessor();
+#if ! MOSES_HEADLESS
+    updateFilterVisualizationCoefficients();
+#endif
 
     for (int simdFilterIdx = 0; simdFilterIdx < maxNumFilters; ++simdFilterIdx)
     {
@@ -117,8 +143,12 @@ MultiBandCompressorAudioProcessor::MultiBandCompressorAudioProcessor() :
 
 MultiBandCompressorAudioProcessor::~MultiBandCompressorAudioProcessor()
 {
-    inputAnalyser.stopThread (1000);
-    outputAnalyser.stopThread (1000);
+#if ! MOSES_HEADLESS
+    inputAnalyser.stopAnalyser();
+    outputAnalyser.stopAnalyser();
+    bandAnalyser.stopAnalyser();
+#endif
+    loudnessMeter.stopMeter();
 }
 
 std::vector<std::unique_ptr<juce::RangedAudioParameter>>
@@ -223,60 +253,154 @@ std::vector<std::unique_ptr<juce::RangedAudioParameter>>
 
 void MultiBandCompressorAudioProcessor::calculateCoefficients (const int i)
 {
-    jassert (lastSampleRate > 0.0);
-
-    const float crossoverFrequency =
-        juce::jmin (static_cast<float> (0.5 * lastSampleRate), crossovers[i]->load());
-
-    double b0, b1, b2, a0, a1, a2;
-    double K = std::tan (juce::MathConstants<double>::pi * (crossoverFrequency) / lastSampleRate);
-    double den = 1 + juce::MathConstants<double>::sqrt2 * K + pow (K, double (2.0));
-
-    // calculate coeffs for 2nd order Butterworth
-    a0 = 1.0;
-    a1 = (2 * (pow (K, 2.0) - 1)) / den;
-    a2 = (1 - juce::MathConstants<double>::sqrt2 * K + pow (K, 2.0)) / den;
-
-    // HP
-    b0 = 1.0 / den;
-    b1 = -2.0 * b0;
-    b2 = b0;
-    iirTempHPCoefficients[i] = new IIR::Coefficients<float> (b0, b1, b2, a0, a1, a2);
-
-    // also calculate 4th order Linkwitz-Riley for GUI
-    IIR::Coefficients<double>::Ptr coeffs (new IIR::Coefficients<double> (b0, b1, b2, a0, a1, a2));
-    coeffs->coefficients =
-        FilterVisualizerHelper<double>::cascadeSecondOrderCoefficients (coeffs->coefficients,
-                                                                        coeffs->coefficients);
-    *highPassLRCoeffs[i] = *coeffs;
-
-    // LP
-    b0 = pow (K, 2.0) / den;
-    b1 = 2.0 * b0;
-    b2 = b0;
-    iirTempLPCoefficients[i] = new IIR::Coefficients<float> (b0, b1, b2, a0, a1, a2);
-
-    coeffs.reset();
-    coeffs = (new IIR::Coefficients<double> (b0, b1, b2, a0, a1, a2));
-    coeffs->coefficients =
-        FilterVisualizerHelper<double>::cascadeSecondOrderCoefficients (coeffs->coefficients,
-                                                                        coeffs->coefficients);
-    *lowPassLRCoeffs[i] = *coeffs;
+    const auto c = coefficientTable.lookup (parameterSnapshot.values[firstCrossoverParameter + i]);
+
+    // written in place, as the filters share these coefficients with the audio thread
+    float* lp = iirLPCoefficients[i]->getRawCoefficients();
+    lp[0] = c.lowPassB0;
+    lp[1] = 2.0f * c.lowPassB0;
+    lp[2] = c.lowPassB0;
+    lp[3] = c.a1;
+    lp[4] = c.a2;
+
+    float* hp = iirHPCoefficients[i]->getRawCoefficients();
+    hp[0] = c.highPassB0;
+    hp[1] = -2.0f * c.highPassB0;
+    hp[2] = c.highPassB0;
+    hp[3] = c.a1;
+    hp[4] = c.a2;
 
     // Allpass equivalent to 4th order Linkwitz-Riley crossover
-    iirTempAPCoefficients[i] = new IIR::Coefficients<float> (a2, a1, a0, a0, a1, a2);
+    float* ap = iirAPCoefficients[i]->getRawCoefficients();
+    ap[0] = c.a2;
+    ap[1] = c.a1;
+    ap[2] = 1.0f;
+    ap[3] = c.a1;
+    ap[4] = c.a2;
 }
 
-void MultiBandCompressorAudioProcessor::copyCoeffsToProcessor()
+#if ! MOSES_HEADLESS
+void MultiBandCompressorAudioProcessor::updateFilterVisualizationCoefficients()
 {
-    for (int filterBandIdx = 0; filterBandIdx < numFilterBands - 1; ++filterBandIdx)
+    // 4th order Linkwitz-Riley for GUI
+    for (int i = 0; i < numFilterBands - 1; ++i)
     {
-        *iirLPCoefficients[filterBandIdx] = *iirTempLPCoefficients[filterBandIdx]; // LP
-        *iirHPCoefficients[filterBandIdx] = *iirTempHPCoefficients[filterBandIdx]; // HP
-        *iirAPCoefficients[filterBandIdx] = *iirTempAPCoefficients[filterBandIdx]; // AP
+        const double crossoverFrequency =
+            juce::jmin (0.5 * lastSampleRate,
+                        double (dspParameters[firstCrossoverParameter + i]->load()));
+
+        double lp[5], hp[5];
+        CrossoverCoefficientTable::calculateButterworthCoefficients (crossoverFrequency,
+                                                                     lastSampleRate,
+                                                                     lp,
+                                                                     hp);
+
+        IIR::Coefficients<double> lowPass (lp[0], lp[1], lp[2], 1.0, lp[3], lp[4]);
+        IIR::Coefficients<double> highPass (hp[0], hp[1], hp[2], 1.0, hp[3], hp[4]);
+
+        lowPassLRCoeffs[i]->coefficients =
+            FilterVisualizerHelper<double>::cascadeSecondOrderCoefficients (lowPass.coefficients,
+                                                                            lowPass.coefficients);
+        highPassLRCoeffs[i]->coefficients =
+            FilterVisualizerHelper<double>::cascadeSecondOrderCoefficients (highPass.coefficients,
+                                                                            highPass.coefficients);
     }
+}
+#endif
+
+void MultiBandCompressorAudioProcessor::invalidateParameterSnapshot()
+{
+    // NaN never compares equal, so every parameter is dirty in the next block
+    for (int i = 0; i < numDspParameters; ++i)
+        parameterSnapshot.values[i] = std::numeric_limits<float>::quiet_NaN();
 
-    userChangedFilterSettings = false;
+    parameterSnapshot.dirty = 0;
+}
+
+void MultiBandCompressorAudioProcessor::updateParameterSnapshot()
+{
+    auto& p = parameterSnapshot;
+
+    p.dirty = 0;
+    for (int i = 0; i < numDspParameters; ++i)
+    {
+        const float value = dspParameters[i]->load (std::memory_order_relaxed);
+        if (value != p.values[i])
+        {
+            p.values[i] = value;
+            p.dirty |= juce::uint32 (1) << i;
+        }
+    }
+
+    if (p.dirty == 0)
+        return;
+
+    p.soloBands = 0;
+    p.killedBands = 0;
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
+    {
+        if (p.dirty & (juce::uint32 (1) << (firstGainParameter + filterBandIdx)))
+            p.bandGains[filterBandIdx] =
+                juce::Decibels::decibelsToGain (p.values[firstGainParameter + filterBandIdx]);
+
+        if (p.values[firstSoloParameter + filterBandIdx] >= 0.5f)
+            p.soloBands |= 1 << filterBandIdx;
+        if (p.values[firstKillParameter + filterBandIdx] >= 0.5f)
+            p.killedBands |= 1 << filterBandIdx;
+    }
+
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands - 1; ++filterBandIdx)
+        if (p.dirty & (juce::uint32 (1) << (firstCrossoverParameter + filterBandIdx)))
+            calculateCoefficients (filterBandIdx);
+}
+
+void MultiBandCompressorAudioProcessor::resetFilterStage (const int stage)
+{
+    auto reset = [this] (juce::OwnedArray<IIR::Filter<IIRfloat>>& filters)
+    {
+        for (int simdFilterIdx = 0; simdFilterIdx < maxNumFilters; ++simdFilterIdx)
+            filters[simdFilterIdx]->reset (IIRfloat (0.0f));
+    };
+
+    switch (stage)
+    {
+        case LowPass1:
+            reset (iirLP[1]);
+            reset (iirLP2[1]);
+            reset (iirAP[2]);
+            break;
+        case HighPass1:
+            reset (iirHP[1]);
+            reset (iirHP2[1]);
+            reset (iirAP[0]);
+            break;
+        case HighPass0:
+            reset (iirHP[0]);
+            reset (iirHP2[0]);
+            break;
+        case LowPass0:
+            reset (iirLP[0]);
+            reset (iirLP2[0]);
+            break;
+        case LowPass2:
+            reset (iirLP[2]);
+            reset (iirLP2[2]);
+            break;
+        case HighPass2:
+            reset (iirHP[2]);
+            reset (iirHP2[2]);
+            break;
+        case LowPass3:
+            reset (iirLP[3]);
+            reset (iirLP2[3]);
+            break;
+        case HighPass3:
+            reset (iirHP[3]);
+            reset (iirHP2[3]);
+            break;
+        default:
+            break;
+    }
 }
 
 //==============================================================================
@@ -316,15 +440,16 @@ void MultiBandCompressorAudioProcessor::prepareToPlay (double sampleRate, int sa
     monoSpec.maximumBlockSize = samplesPerBlock;
     monoSpec.numChannels = 1;
 
-    inputPeak = juce::Decibels::gainToDecibels (-INFINITY);
-    outputPeak = juce::Decibels::gainToDecibels (-INFINITY);
+    meterTelemetry.setMaxWindowLength (int (sampleRate));
+    loadMeter.prepare (sampleRate);
 
-    for (int filterBandIdx = 0; filterBandIdx < numFilterBands - 1; ++filterBandIdx)
-    {
-        calculateCoefficients (filterBandIdx);
-    }
+    const int numChannels = juce::jmax (1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    loudnessMeter.setupMeter (sampleRate, samplesPerBlock, 1 + (numChannels - 1) / IIRfloat_elements);
+    loudnessMeter.startMeter();
 
-    copyCoeffsToProcessor();
+    // recalculates all coefficients for the new sample rate with the next block
+    coefficientTable.prepare (sampleRate);
+    invalidateParameterSnapshot();
 
     interleavedData.clear();
     for (int simdFilterIdx = 0; simdFilterIdx < maxNumFilters; ++simdFilterIdx)
@@ -353,6 +478,16 @@ void MultiBandCompressorAudioProcessor::prepareToPlay (double sampleRate, int sa
         }
     }
 
+    // kill and solo switches ramp over 5 ms, gain changes and bands with woken up filters over 20 ms
+    bandMaskRampLength = juce::jmax (1, juce::roundToInt (0.005 * sampleRate));
+    gainRampLength = juce::jmax (1, juce::roundToInt (0.02 * sampleRate));
+    warmUpLength = juce::jmax (1, juce::roundToInt (0.02 * sampleRate));
+    for (int stage = 0; stage < numFilterStages; ++stage)
+        stageWasProcessed[stage] = true;
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
+        bandGainRamps[filterBandIdx] = {};
+    lastActiveBands = 0;
+
     for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
     {
         freqBands[filterBandIdx].clear();
@@ -371,22 +506,77 @@ void MultiBandCompressorAudioProcessor::prepareToPlay (double sampleRate, int sa
     gains = juce::dsp::AudioBlock<float> (gainData, 1, samplesPerBlock);
     gains.clear();
 
-    tempBuffer.setSize (64, samplesPerBlock, false, true);
-
+#if ! MOSES_HEADLESS
     inputAnalyser.setupAnalyser  (int (sampleRate), float (sampleRate));
     outputAnalyser.setupAnalyser (int (sampleRate), float (sampleRate));
+    bandAnalyser.setupAnalyser (int (sampleRate), float (sampleRate));
+    bandAnalyserData.setSize (numFilterBands, samplesPerBlock);
+    analysersArePrepared = true;
+    updateAnalysers();
 
     repaintFilterVisualization = true;
+#endif
 }
 
 void MultiBandCompressorAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
-    inputAnalyser.stopThread (1000);
-    outputAnalyser.stopThread (1000);
+#if ! MOSES_HEADLESS
+    analysersArePrepared = false;
+    updateAnalysers();
+#endif
+    loudnessMeter.stopMeter();
 }
 
+#if ! MOSES_HEADLESS
+void MultiBandCompressorAudioProcessor::setEditorVisible (const bool isVisible)
+{
+    editorIsVisible = isVisible;
+    updateAnalysers();
+}
+
+void MultiBandCompressorAudioProcessor::updateAnalysers()
+{
+    if (editorIsVisible.get() && analysersArePrepared.get())
+    {
+        inputAnalyser.startAnalyser();
+        outputAnalyser.startAnalyser();
+        bandAnalyser.startAnalyser();
+    }
+    else
+    {
+        inputAnalyser.stopAnalyser();
+        outputAnalyser.stopAnalyser();
+        bandAnalyser.stopAnalyser();
+    }
+}
+
+void MultiBandCompressorAudioProcessor::setAnalyserSettings (const Analyser<float>::Settings& newSettings)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock (analyserSettingsLock);
+        analyserSettings = newSettings;
+    }
+
+    inputAnalyser.setSettings (newSettings);
+    outputAnalyser.setSettings (newSettings);
+    bandAnalyser.setSettings (newSettings);
+}
+
+Analyser<float>::Settings MultiBandCompressorAudioProcessor::getAnalyserSettings() const
+{
+    const juce::SpinLock::ScopedLockType lock (analyserSettingsLock);
+    return analyserSettings;
+}
+
+int MultiBandCompressorAudioProcessor::getNumDroppedAnalyserBlocks() const
+{
+    return inputAnalyser.getNumDroppedBlocks() + outputAnalyser.getNumDroppedBlocks()
+           + bandAnalyser.getNumDroppedBlocks();
+}
+#endif
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool MultiBandCompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
@@ -404,8 +594,25 @@ void MultiBandCompressorAudioProcessor::processBlock (juce::AudioSampleBuffer& b
     if (maxNChIn < 1)
         return;
 
-    if (getActiveEditor() != nullptr)
+    const auto blockStartTicks = juce::Time::getHighResolutionTicks();
+#if MOSES_STAGE_PROFILING
+    stageProfiler.beginBlock();
+#endif
+
+#if MOSES_HEADLESS
+    constexpr bool feedAnalysers = false; // nobody to look at them
+#else
+    const bool feedAnalysers = editorIsVisible.get();
+#endif
+    // peak and RMS levels are only shown by the editor, the loudness also goes out over OSC
+    const bool computeMeters = feedAnalysers;
+    const bool computeLoudness = feedAnalysers || oscParameterInterface.getOSCSender().isConnected();
+
+#if ! MOSES_HEADLESS
+    if (feedAnalysers)
         inputAnalyser.addAudioData (buffer, 0, getTotalNumInputChannels());
+#endif
+    MOSES_PROFILE_LAP (meteringStage);
 
     const int L = buffer.getNumSamples();
     const int nSIMDFilters = 1 + (maxNChIn - 1) / IIRfloat_elements;
@@ -414,11 +621,63 @@ void MultiBandCompressorAudioProcessor::processBlock (juce::AudioSampleBuffer& b
     gains.clear();
     zero.clear();
 
-    // update iir filter coefficients
-    if (userChangedFilterSettings.get())
-        copyCoeffsToProcessor();
+    // read all parameters once, updates the filter coefficients if needed
+    updateParameterSnapshot();
+
+    if (computeMeters)
+        meterTelemetry.beginBlock (maxNChIn);
+
+    // the loudness meter gets copies of the interleaved blocks, it does all the filtering on its own thread
+    const bool measureLoudness = computeLoudness && L > 0 && loudnessMeter.beginBlock (L, nSIMDFilters, maxNChIn);
 
-    inputPeak = juce::Decibels::gainToDecibels(buffer.getMagnitude(0, 0, L));
+    // bands which end up in the output, or are still fading out
+    const int soloBands = parameterSnapshot.soloBands;
+    const int activeBands = (soloBands == 0 ? allBandsMask : soloBands) & ~parameterSnapshot.killedBands;
+
+    // every band ramps to its new gain, kill and solo switches ramp faster than gain changes
+    int audibleBands = 0;
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
+    {
+        const int bandBit = 1 << filterBandIdx;
+        auto& ramp = bandGainRamps[filterBandIdx];
+
+        const float targetGain =
+            (activeBands & bandBit) ? parameterSnapshot.bandGains[filterBandIdx] : 0.0f;
+        if (targetGain != ramp.target)
+            ramp.rampTo (targetGain,
+                         ((activeBands ^ lastActiveBands) & bandBit) ? bandMaskRampLength
+                                                                      : gainRampLength);
+
+        if (ramp.gain != 0.0f || ramp.target != 0.0f)
+            audibleBands |= bandBit;
+    }
+    lastActiveBands = activeBands;
+
+    const int neededBands = lazyBandEvaluation.get() ? audibleBands : allBandsMask;
+
+    // stages coming back from being skipped start from a cleared state, the bands they feed get faded in
+    bool processStage[numFilterStages];
+    for (int stage = 0; stage < numFilterStages; ++stage)
+    {
+        processStage[stage] = (stageBandMasks[stage] & neededBands) != 0;
+
+        if (processStage[stage] && ! stageWasProcessed[stage])
+        {
+            resetFilterStage (stage);
+            for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
+            {
+                if (stageBandMasks[stage] & activeBands & (1 << filterBandIdx))
+                {
+                    auto& ramp = bandGainRamps[filterBandIdx];
+                    ramp.gain = 0.0f;
+                    ramp.rampTo (ramp.target, warmUpLength);
+                }
+            }
+        }
+
+        stageWasProcessed[stage] = processStage[stage];
+    }
+    MOSES_PROFILE_LAP (setupStage);
 
     using Format = juce::AudioData::Format<juce::AudioData::Float32, juce::AudioData::NativeEndian>;
 
@@ -473,6 +732,7 @@ void MultiBandCompressorAudioProcessor::processBlock (juce::AudioSampleBuffer& b
                 IIRfloat_elements },
             L);
     }
+    MOSES_PROFILE_LAP (interleaveStage);
 
     //  filter block diagram
     //                                | ---> HP3 ---> |
@@ -519,136 +779,242 @@ void MultiBandCompressorAudioProcessor::processBlock (juce::AudioSampleBuffer& b
 
 
         // Traitement de la bande Low
-        iirLP[1][simdFilterIdx]->process(
-            juce::dsp::ProcessContextNonReplacing<IIRfloat>(abInterleaved, abLow));
-        iirHP[1][simdFilterIdx]->process(
-            juce::dsp::ProcessContextNonReplacing<IIRfloat>(abInterleaved, abHigh));
+        if (processStage[LowPass1])
+        {
+            iirLP[1][simdFilterIdx]->process(
+                juce::dsp::ProcessContextNonReplacing<IIRfloat>(abInterleaved, abLow));
+            iirLP2[1][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
+            iirAP[2][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
+            MOSES_PROFILE_LAP (firstFilterStage + LowPass1);
+        }
 
-        iirLP2[1][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
-        iirHP2[1][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
+        if (processStage[HighPass1])
+        {
+            iirHP[1][simdFilterIdx]->process(
+                juce::dsp::ProcessContextNonReplacing<IIRfloat>(abInterleaved, abHigh));
+            iirHP2[1][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
+            iirAP[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
+            MOSES_PROFILE_LAP (firstFilterStage + HighPass1);
+        }
 
         // Traitement de la bande MidLow
-        iirAP[2][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
-        iirAP[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
-
-        iirHP[0][simdFilterIdx]->process(
-            juce::dsp::ProcessContextNonReplacing<IIRfloat>(abLow, abMidLow));
-        iirHP2[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abMidLow));
+        if (processStage[HighPass0])
+        {
+            iirHP[0][simdFilterIdx]->process(
+                juce::dsp::ProcessContextNonReplacing<IIRfloat>(abLow, abMidLow));
+            iirHP2[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abMidLow));
+            MOSES_PROFILE_LAP (firstFilterStage + HighPass0);
+        }
 
-        iirLP[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
-        iirLP2[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
+        if (processStage[LowPass0])
+        {
+            iirLP[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
+            iirLP2[0][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abLow));
+            MOSES_PROFILE_LAP (firstFilterStage + LowPass0);
+        }
 
         // Traitement de la bande Mid (nouvelle bande)
-        iirLP[2][simdFilterIdx]->process(
-            juce::dsp::ProcessContextNonReplacing<IIRfloat>(abMidLow, abMid));
-        iirHP[2][simdFilterIdx]->process(
-            juce::dsp::ProcessContextNonReplacing<IIRfloat>(abMidLow, abMidHigh));
+        if (processStage[LowPass2])
+        {
+            iirLP[2][simdFilterIdx]->process(
+                juce::dsp::ProcessContextNonReplacing<IIRfloat>(abMidLow, abMid));
+            iirLP2[2][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abMid));
+            MOSES_PROFILE_LAP (firstFilterStage + LowPass2);
+        }
 
-        iirLP2[2][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abMid));
-        iirHP2[2][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abMidHigh));
+        if (processStage[HighPass2])
+        {
+            iirHP[2][simdFilterIdx]->process(
+                juce::dsp::ProcessContextNonReplacing<IIRfloat>(abMidLow, abMidHigh));
+            iirHP2[2][simdFilterIdx]->process(
+                juce::dsp::ProcessContextReplacing<IIRfloat>(abMidHigh));
+            MOSES_PROFILE_LAP (firstFilterStage + HighPass2);
+        }
 
         // Traitement de la bande MidHigh
-        iirLP[3][simdFilterIdx]->process(
-            juce::dsp::ProcessContextNonReplacing<IIRfloat>(abHigh, abMidHigh));
-        iirLP2[3][simdFilterIdx]->process(
-            juce::dsp::ProcessContextReplacing<IIRfloat>(abMidHigh));
+        if (processStage[LowPass3])
+        {
+            iirLP[3][simdFilterIdx]->process(
+                juce::dsp::ProcessContextNonReplacing<IIRfloat>(abHigh, abMidHigh));
+            iirLP2[3][simdFilterIdx]->process(
+                juce::dsp::ProcessContextReplacing<IIRfloat>(abMidHigh));
+            MOSES_PROFILE_LAP (firstFilterStage + LowPass3);
+        }
 
-        iirHP[3][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
-        iirHP2[3][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
+        if (processStage[HighPass3])
+        {
+            iirHP[3][simdFilterIdx]->process(juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
+            iirHP2[3][simdFilterIdx]->process(
+                juce::dsp::ProcessContextReplacing<IIRfloat>(abHigh));
+            MOSES_PROFILE_LAP (firstFilterStage + HighPass3);
+        }
+    }
+
+    // Sum up the bands, still interleaved: the input data isn't needed anymore, so it's reused for the sum
+    for (int simdFilterIdx = 0; simdFilterIdx < nSIMDFilters; ++simdFilterIdx)
+    {
+        if (measureLoudness)
+            loudnessMeter.writeSignal (Meters::input, simdFilterIdx, interleavedData[simdFilterIdx]->getChannelPointer (0));
 
+        if (computeMeters)
+        {
+            IIRfloat peak = 0.0f, sumOfSquares = 0.0f;
+            measureAndClear (*interleavedData[simdFilterIdx], L, peak, sumOfSquares);
+            addLevels (Meters::input, simdFilterIdx, peak, sumOfSquares);
+        }
+        else
+            clear (*interleavedData[simdFilterIdx]);
     }
 
-    buffer.clear();
+    // the output is measured while the last audible band is added to the sum
+    int lastAudibleBand = -1;
+    for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
+        if (audibleBands & (1 << filterBandIdx))
+            lastAudibleBand = filterBandIdx;
+
+#if ! MOSES_HEADLESS
+    // the band analyser gets each band after its gain ramp, summed over all channels
+    if (feedAnalysers)
+        bandAnalyserData.clear();
+#endif
 
     for (int filterBandIdx = 0; filterBandIdx < numFilterBands; ++filterBandIdx)
     {
-        // Vérifier si la bande est en mode Kill
-        if (killArray[filterBandIdx])
-        {
-            continue;  // Si c'est le cas, ne pas l'ajouter au mix final
-        }
-        if (!soloArray.isZero())
+        auto& ramp = bandGainRamps[filterBandIdx];
+        const float startGain = ramp.gain;
+
+        if (startGain == 0.0f && ramp.target == 0.0f)
+            continue;
+
+        const int numRampSamples = juce::jmin (L, ramp.samplesLeft);
+        ramp.samplesLeft -= numRampSamples;
+        ramp.gain = ramp.samplesLeft == 0 ? ramp.target : startGain + numRampSamples * ramp.step;
+
+        // the measuring kernels are only used if someone looks at the meters
+        const bool measureSum = computeMeters && filterBandIdx == lastAudibleBand;
+        const auto addBand =
+            ! computeMeters ? &MultiBandCompressorAudioProcessor::addBandToSum<false, false>
+            : measureSum    ? &MultiBandCompressorAudioProcessor::addBandToSum<true, true>
+                            : &MultiBandCompressorAudioProcessor::addBandToSum<true, false>;
+
+        if (measureLoudness)
+            loudnessMeter.setGainRamp (Meters::firstBand + filterBandIdx, startGain, ramp.step, numRampSamples, ramp.gain);
+
+        for (int simdFilterIdx = 0; simdFilterIdx < nSIMDFilters; ++simdFilterIdx)
         {
-            if (!soloArray[filterBandIdx])
-            {
-                continue;
-            }
+            IIRfloat peak = 0.0f, sumOfSquares = 0.0f, sumPeak = 0.0f, sumSumOfSquares = 0.0f;
+            (this->*addBand) (freqBands[filterBandIdx][simdFilterIdx]->getChannelPointer (0),
+                              interleavedData[simdFilterIdx]->getChannelPointer (0),
+                              L,
+                              startGain,
+                              ramp.step,
+                              numRampSamples,
+                              ramp.gain,
+                              peak,
+                              sumOfSquares,
+                              sumPeak,
+                              sumSumOfSquares);
+
+            if (computeMeters)
+                addLevels (Meters::firstBand + filterBandIdx, simdFilterIdx, peak, sumOfSquares);
+            if (measureSum)
+                addLevels (Meters::output, simdFilterIdx, sumPeak, sumSumOfSquares);
+            if (measureLoudness)
+                loudnessMeter.writeSignal (Meters::firstBand + filterBandIdx,
+                                           simdFilterIdx,
+                                           freqBands[filterBandIdx][simdFilterIdx]->getChannelPointer (0));
         }
 
-        tempBuffer.clear();
+#if ! MOSES_HEADLESS
+        if (feedAnalysers)
+            sumBandForAnalyser (filterBandIdx, nSIMDFilters, L, startGain, ramp.step, numRampSamples, ramp.gain);
+#endif
+    }
+    MOSES_PROFILE_LAP (summationStage);
+
+    if (measureLoudness)
+    {
+        for (int simdFilterIdx = 0; simdFilterIdx < nSIMDFilters; ++simdFilterIdx)
+            loudnessMeter.writeSignal (Meters::output, simdFilterIdx, interleavedData[simdFilterIdx]->getChannelPointer (0));
+        loudnessMeter.finishBlock();
+    }
 
-        // Deinterleave
-        if (partial == 0)
+#if ! MOSES_HEADLESS
+    if (feedAnalysers)
+        bandAnalyser.addStreamData (bandAnalyserData, L);
+#endif
+    MOSES_PROFILE_LAP (meteringStage);
+
+    // Deinterleave
+    if (partial == 0)
+    {
+        for (int simdFilterIdx = 0; simdFilterIdx < nSIMDFilters; ++simdFilterIdx)
         {
-            for (int simdFilterIdx = 0; simdFilterIdx < nSIMDFilters; ++simdFilterIdx)
-            {
-                juce::AudioData::deinterleaveSamples(
-                    juce::AudioData::InterleavedSource<Format> {
-                        reinterpret_cast<float*>(
-                            freqBands[filterBandIdx][simdFilterIdx]->getChannelPointer(0)),
-                        IIRfloat_elements },
-                    juce::AudioData::NonInterleavedDest<Format> {
-                        tempBuffer.getArrayOfWritePointers() + simdFilterIdx * IIRfloat_elements,
-                        IIRfloat_elements },
-                    L);
-            }
+            juce::AudioData::deinterleaveSamples(
+                juce::AudioData::InterleavedSource<Format> {
+                    reinterpret_cast<float*>(interleavedData[simdFilterIdx]->getChannelPointer(0)),
+                    IIRfloat_elements },
+                juce::AudioData::NonInterleavedDest<Format> {
+                    buffer.getArrayOfWritePointers() + simdFilterIdx * IIRfloat_elements,
+                    IIRfloat_elements },
+                L);
         }
-        else
+    }
+    else
+    {
+        int simdFilterIdx;
+        for (simdFilterIdx = 0; simdFilterIdx < nSIMDFilters - 1; ++simdFilterIdx)
         {
-            int simdFilterIdx;
-            for (simdFilterIdx = 0; simdFilterIdx < nSIMDFilters - 1; ++simdFilterIdx)
-            {
-                juce::AudioData::deinterleaveSamples(
-                    juce::AudioData::InterleavedSource<Format> {
-                        reinterpret_cast<float*>(
-                            freqBands[filterBandIdx][simdFilterIdx]->getChannelPointer(0)),
-                        IIRfloat_elements },
-                    juce::AudioData::NonInterleavedDest<Format> {
-                        tempBuffer.getArrayOfWritePointers() + simdFilterIdx * IIRfloat_elements,
-                        IIRfloat_elements },
-                    L);
-            }
-
-            float* addr[IIRfloat_elements];
-            int iirElementIdx;
-            for (iirElementIdx = 0; iirElementIdx < partial; ++iirElementIdx)
-            {
-                addr[iirElementIdx] =
-                    tempBuffer.getWritePointer(simdFilterIdx * IIRfloat_elements + iirElementIdx);
-            }
-            for (; iirElementIdx < IIRfloat_elements; ++iirElementIdx)
-            {
-                addr[iirElementIdx] = zero.getChannelPointer(iirElementIdx);
-            }
             juce::AudioData::deinterleaveSamples(
                 juce::AudioData::InterleavedSource<Format> {
-                    reinterpret_cast<float*>(
-                        freqBands[filterBandIdx][simdFilterIdx]->getChannelPointer(0)),
+                    reinterpret_cast<float*>(interleavedData[simdFilterIdx]->getChannelPointer(0)),
+                    IIRfloat_elements },
+                juce::AudioData::NonInterleavedDest<Format> {
+                    buffer.getArrayOfWritePointers() + simdFilterIdx * IIRfloat_elements,
                     IIRfloat_elements },
-                juce::AudioData::NonInterleavedDest<Format> { addr, IIRfloat_elements },
                 L);
-            zero.clear();
         }
 
-        // Apply band gain
-        float bandGain = juce::Decibels::decibelsToGain(gain[filterBandIdx]->load());
-        for (int ch = 0; ch < maxNChIn; ++ch)
+        float* addr[IIRfloat_elements];
+        int iirElementIdx;
+        for (iirElementIdx = 0; iirElementIdx < partial; ++iirElementIdx)
         {
-            juce::FloatVectorOperations::multiply(tempBuffer.getWritePointer(ch), bandGain, L);
-            juce::FloatVectorOperations::add(buffer.getWritePointer(ch),
-                                             tempBuffer.getReadPointer(ch),
-                                             L);
-            maxPeak[filterBandIdx] = juce::Decibels::gainToDecibels(
-                                                    tempBuffer.getMagnitude(ch, 0, L));
+            addr[iirElementIdx] =
+                buffer.getWritePointer(simdFilterIdx * IIRfloat_elements + iirElementIdx);
         }
+        for (; iirElementIdx < IIRfloat_elements; ++iirElementIdx)
+        {
+            addr[iirElementIdx] = zero.getChannelPointer(iirElementIdx);
+        }
+        juce::AudioData::deinterleaveSamples(
+            juce::AudioData::InterleavedSource<Format> {
+                reinterpret_cast<float*>(interleavedData[simdFilterIdx]->getChannelPointer(0)),
+                IIRfloat_elements },
+            juce::AudioData::NonInterleavedDest<Format> { addr, IIRfloat_elements },
+            L);
+        zero.clear();
     }
+    MOSES_PROFILE_LAP (deinterleaveStage);
 
-
-    if (getActiveEditor() != nullptr)
+#if ! MOSES_HEADLESS
+    if (feedAnalysers)
         outputAnalyser.addAudioData (buffer, 0, getTotalNumOutputChannels());
-    outputPeak = juce::Decibels::gainToDecibels(buffer.getMagnitude(0, 0, L));
+#endif
+    if (feedAnalysers || measureLoudness)
+        analysisService->notify(); // one wake-up for the analysers and the loudness meter
+    if (computeMeters)
+        meterTelemetry.publish (L);
+    MOSES_PROFILE_LAP (meteringStage);
+#if MOSES_STAGE_PROFILING
+    stageProfiler.endBlock();
+#endif
+
+    // share of the block's duration spent processing it, offline rendering has no budget to keep
+    if (L > 0 && ! isNonRealtime())
+        frameScheduler->reportAudioLoad (loadMeter.registerBlock (blockStartTicks, L));
 }
 
+#if ! MOSES_HEADLESS
 void MultiBandCompressorAudioProcessor::createAnalyserPlot (juce::Path& p, const juce::Rectangle<int> bounds, float minFreq, bool input)
 {
     if (input)
@@ -661,16 +1027,25 @@ bool MultiBandCompressorAudioProcessor::checkForNewAnalyserData()
 {
     return inputAnalyser.checkForNewData() || outputAnalyser.checkForNewData();
 }
+#endif
 
 //==============================================================================
 bool MultiBandCompressorAudioProcessor::hasEditor() const
 {
+#if MOSES_HEADLESS
+    return false;
+#else
     return true; // (change this to false if you choose to not supply an editor)
+#endif
 }
 
 juce::AudioProcessorEditor* MultiBandCompressorAudioProcessor::createEditor()
 {
+#if MOSES_HEADLESS
+    return nullptr;
+#else
     return new MultiBandCompressorAudioProcessorEditor (*this, parameters);
+#endif
 }
 
 //==============================================================================
@@ -681,6 +1056,17 @@ void MultiBandCompressorAudioProcessor::getStateInformation (juce::MemoryBlock&
     auto oscConfig = state.getOrCreateChildWithName ("OSCConfig", nullptr);
     oscConfig.copyPropertiesFrom (oscParameterInterface.getConfig(), nullptr);
 
+#if ! MOSES_HEADLESS
+    const auto settings = getAnalyserSettings();
+    auto analyserConfig = state.getOrCreateChildWithName ("AnalyserConfig", nullptr);
+    analyserConfig.setProperty ("FftOrder", settings.fftOrder, nullptr);
+    analyserConfig.setProperty ("HopSize", settings.hopSize, nullptr);
+    analyserConfig.setProperty ("PeakHold", settings.averaging == Analyser<float>::peakHold, nullptr);
+    analyserConfig.setProperty ("ExponentialWeight", settings.exponentialWeight, nullptr);
+    analyserConfig.setProperty ("PeakHoldDecay", settings.peakHoldDecay, nullptr);
+    analyserConfig.setProperty ("DecimatedLowBand", settings.decimatedLowBand, nullptr);
+#endif
+
     std::unique_ptr<juce::XmlElement> xml (state.createXml());
     copyXmlToBinary (*xml, destData);
 }
@@ -702,47 +1088,180 @@ void MultiBandCompressorAudioProcessor::setStateInformation (const void* data, i
             auto oscConfig = parameters.state.getChildWithName ("OSCConfig");
             if (oscConfig.isValid())
                 oscParameterInterface.setConfig (oscConfig);
+
+#if ! MOSES_HEADLESS
+            auto analyserConfig = parameters.state.getChildWithName ("AnalyserConfig");
+            if (analyserConfig.isValid())
+            {
+                Analyser<float>::Settings settings;
+                settings.fftOrder = analyserConfig.getProperty ("FftOrder", settings.fftOrder);
+                settings.hopSize = analyserConfig.getProperty ("HopSize", settings.hopSize);
+                settings.averaging = analyserConfig.getProperty ("PeakHold", false) ? Analyser<float>::peakHold
+                                                                                     : Analyser<float>::exponential;
+                settings.exponentialWeight = analyserConfig.getProperty ("ExponentialWeight", settings.exponentialWeight);
+                settings.peakHoldDecay = analyserConfig.getProperty ("PeakHoldDecay", settings.peakHoldDecay);
+                settings.decimatedLowBand = analyserConfig.getProperty ("DecimatedLowBand", settings.decimatedLowBand);
+                setAnalyserSettings (settings);
+            }
+#endif
         }
 }
 
-//==============================================================================
-void MultiBandCompressorAudioProcessor::parameterChanged (const juce::String& parameterID,
-                                                          float newValue)
+void MultiBandCompressorAudioProcessor::sendAdditionalOSCMessages (juce::OSCSender& oscSender,
+                                                                   const juce::OSCAddressPattern& address)
 {
-    DBG ("Parameter with ID " << parameterID << " has changed. New value: " << newValue);
+    // momentary and short-term loudness in LUFS, true peak in dBTP and crest factor in dB
+    const juce::String prefix = address.toString() + "loudness/";
+    for (int source = 0; source < Meters::numSources; ++source)
+    {
+        const auto levels = loudnessMeter.getLevels (source);
+        const auto name = source == Meters::input    ? juce::String ("input")
+                          : source == Meters::output ? juce::String ("output")
+                                                     : "band" + juce::String (source - Meters::firstBand);
+        try
+        {
+            oscSender.send (juce::OSCMessage (prefix + name,
+                                              levels.momentaryLoudness,
+                                              levels.shortTermLoudness,
+                                              levels.truePeak,
+                                              levels.crestFactor));
+        }
+        catch (...)
+        {
+        };
+    }
 
-    if (parameterID.startsWith ("crossover"))
+    // smoothed load, median, 99th percentile and highest load of the last seconds, as proportions of the
+    // real-time budget, the blocks over budget within the last seconds and in total
+    const auto load = loadMeter.getStatistics();
+    try
     {
-        calculateCoefficients (parameterID.getLastCharacters (1).getIntValue());
-        userChangedFilterSettings = true;
-        repaintFilterVisualization = true;
+        oscSender.send (juce::OSCMessage (address.toString() + "load",
+                                          load.load,
+                                          load.p50,
+                                          load.p99,
+                                          load.max,
+                                          load.numRecentXruns,
+                                          load.numXruns));
     }
-    else if (parameterID.startsWith ("solo"))
+    catch (...)
     {
-        if (newValue >= 0.5f)
-            soloArray.setBit (parameterID.getLastCharacters (1).getIntValue());
-        else
-            soloArray.clearBit (parameterID.getLastCharacters (1).getIntValue());
+    };
+
+#if ! MOSES_HEADLESS
+    // audio blocks the analysers had to drop, as the analysis service couldn't keep up
+    try
+    {
+        oscSender.send (juce::OSCMessage (address.toString() + "analyser/dropped",
+                                          inputAnalyser.getNumDroppedBlocks(),
+                                          outputAnalyser.getNumDroppedBlocks(),
+                                          bandAnalyser.getNumDroppedBlocks()));
     }
-    else if (parameterID.startsWith("kill"))
+    catch (...)
     {
-        if (newValue >= 0.5f)
-            killArray.setBit(parameterID.getLastCharacters(1).getIntValue());
-        else
-            killArray.clearBit(parameterID.getLastCharacters(1).getIntValue());
+    };
+#endif
+}
+
+const bool MultiBandCompressorAudioProcessor::processNotYetConsumedOSCMessage (const juce::OSCMessage& message)
+{
+    const auto address = message.getAddressPattern().toString();
+    const juce::String prefix ("/" + juce::String (JucePlugin_Name));
+
+    // forgets the load histogram and the xruns
+    if (address.equalsIgnoreCase (prefix + "/load/reset"))
+    {
+        loadMeter.reset();
+        return true;
     }
-    else if (parameterID.startsWith ("gain"))
+
+#if ! MOSES_HEADLESS
+    // /Moses/analyser fftOrder [hopSize [peakHold]], a hop size of 0 is half the fft size
+    if (address.equalsIgnoreCase (prefix + "/analyser") && message.size() > 0)
     {
-        const int bandId = parameterID.getLastCharacters (1).getIntValue();
-        gain[bandId]->store(newValue);
-        repaintFilterVisualization = true;
+        auto getInt = [&message] (const int index, const int defaultValue)
+        {
+            if (index >= message.size())
+                return defaultValue;
+            const auto& argument = message[index];
+            return argument.isInt32()     ? argument.getInt32()
+                   : argument.isFloat32() ? juce::roundToInt (argument.getFloat32())
+                                          : defaultValue;
+        };
+
+        auto settings = getAnalyserSettings();
+        settings.fftOrder = juce::jlimit (Analyser<float>::minFftOrder, Analyser<float>::maxFftOrder, getInt (0, settings.fftOrder));
+        settings.hopSize = juce::jmax (0, getInt (1, settings.hopSize));
+        settings.averaging = getInt (2, settings.averaging == Analyser<float>::peakHold) != 0 ? Analyser<float>::peakHold
+                                                                                              : Analyser<float>::exponential;
+        setAnalyserSettings (settings);
+        return true;
     }
-    else
+#endif
+
+#if MOSES_STAGE_PROFILING
+    // /Moses/profile replies with the statistics of every stage, /Moses/profile/reset starts over
+    if (address.equalsIgnoreCase (prefix + "/profile"))
+    {
+        stageProfileReply.triggerAsyncUpdate();
+        return true;
+    }
+
+    if (address.equalsIgnoreCase (prefix + "/profile/reset"))
     {
-        DBG ("Parameter with ID " << parameterID << " has changed. New value: " << newValue);
+        stageProfiler.reset();
+        return true;
     }
+#endif
+
+    return false;
 }
 
+#if MOSES_STAGE_PROFILING
+juce::String MultiBandCompressorAudioProcessor::getProfiledStageName (const int stage)
+{
+    static const char* const filterStageNames[numFilterStages] = { "lowPass1", "highPass1", "highPass0", "lowPass0",
+                                                                   "lowPass2", "highPass2", "lowPass3", "highPass3" };
+
+    switch (stage)
+    {
+        case setupStage:        return "setup";
+        case interleaveStage:   return "interleave";
+        case summationStage:    return "summation";
+        case meteringStage:     return "metering";
+        case deinterleaveStage: return "deinterleave";
+        default:                return filterStageNames[stage - firstFilterStage];
+    }
+}
+
+void MultiBandCompressorAudioProcessor::sendStageProfile()
+{
+    auto& oscSender = oscParameterInterface.getOSCSender();
+    if (! oscSender.isConnected())
+        return;
+
+    // blocks, mean, median, 99th percentile and longest time per block in microseconds, share of the total time
+    const juce::String prefix = oscParameterInterface.getOSCAddress() + "profile/";
+    for (int stage = 0; stage < numProfiledStages; ++stage)
+    {
+        const auto statistics = stageProfiler.getStatistics (stage);
+        try
+        {
+            juce::OSCMessage message (prefix + getProfiledStageName (stage));
+            message.addInt32 (int (juce::jmin (statistics.numBlocks, juce::int64 (std::numeric_limits<int>::max()))));
+            message.addFloat32 (float (statistics.mean));
+            message.addFloat32 (float (statistics.p50));
+            message.addFloat32 (float (statistics.p99));
+            message.addFloat32 (float (statistics.max));
+            message.addFloat32 (float (statistics.share));
+            oscSender.send (message);
+        }
+        catch (...)
+        {
+        };
+    }
+}
+#endif
 
 //==============================================================================
 // This creates new instances of the plugin..
@@ -751,6 +1270,133 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new MultiBandCompressorAudioProcessor();
 }
 
+// adds a band with its gain ramp to the sum, optionally measuring the band and the resulting sum
+template <bool measureBand, bool measureSum>
+inline void MultiBandCompressorAudioProcessor::addBandToSum (const IIRfloat* band,
+                                                             IIRfloat* sum,
+                                                             const int numSamples,
+                                                             float gain,
+                                                             const float gainStep,
+                                                             const int numRampSamples,
+                                                             const float endGain,
+                                                             IIRfloat& peak,
+                                                             IIRfloat& sumOfSquares,
+                                                             IIRfloat& sumPeak,
+                                                             IIRfloat& sumSumOfSquares)
+{
+    auto addSample = [&] (const int i, const float sampleGain)
+    {
+        const IIRfloat sample = band[i] * sampleGain;
+        const IIRfloat newSum = sum[i] + sample;
+        sum[i] = newSum;
+
+        if (measureBand)
+        {
+            peak = absMax (peak, sample);
+            sumOfSquares += sample * sample;
+        }
+
+        if (measureSum)
+        {
+            sumPeak = absMax (sumPeak, newSum);
+            sumSumOfSquares += newSum * newSum;
+        }
+    };
+
+    int i = 0;
+    for (; i < numRampSamples; ++i)
+    {
+        addSample (i, gain);
+        gain += gainStep;
+    }
+
+    for (; i < numSamples; ++i)
+        addSample (i, endGain);
+}
+
+#if ! MOSES_HEADLESS
+// the band with its gain ramp, summed over all channels, as the band analyser's stream of it
+void MultiBandCompressorAudioProcessor::sumBandForAnalyser (const int filterBandIdx,
+                                                            const int nSIMDFilters,
+                                                            const int numSamples,
+                                                            float gain,
+                                                            const float gainStep,
+                                                            const int numRampSamples,
+                                                            const float endGain)
+{
+    constexpr int chunkSize = 32;
+    IIRfloat channelSums[chunkSize];
+    float* bandSum = bandAnalyserData.getWritePointer (filterBandIdx);
+    const auto& bands = freqBands[filterBandIdx];
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int n = juce::jmin (chunkSize, numSamples - start);
+
+        // the registers of all channels added up first, one horizontal sum per sample remains
+        const IIRfloat* band = bands[0]->getChannelPointer (0) + start;
+        for (int i = 0; i < n; ++i)
+            channelSums[i] = band[i];
+
+        for (int simdFilterIdx = 1; simdFilterIdx < nSIMDFilters; ++simdFilterIdx)
+        {
+            band = bands[simdFilterIdx]->getChannelPointer (0) + start;
+            for (int i = 0; i < n; ++i)
+                channelSums[i] += band[i];
+        }
+
+        // the same gain for each sample as addBandToSum()
+        for (int i = 0; i < n; ++i)
+        {
+            if (start + i < numRampSamples)
+            {
+                bandSum[start + i] = sumOfElements (channelSums[i]) * gain;
+                gain += gainStep;
+            }
+            else
+                bandSum[start + i] = sumOfElements (channelSums[i]) * endGain;
+        }
+    }
+}
+#endif
+
+inline void MultiBandCompressorAudioProcessor::measureAndClear (AudioBlock<IIRfloat>& ab,
+                                                                const int numSamples,
+                                                                IIRfloat& peak,
+                                                                IIRfloat& sumOfSquares)
+{
+    IIRfloat* data = ab.getChannelPointer (0);
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const IIRfloat sample = data[i];
+        peak = absMax (peak, sample);
+        sumOfSquares += sample * sample;
+        data[i] = 0.0f;
+    }
+
+    // the block may be longer than this one
+    const int blockLength = static_cast<int> (ab.getNumSamples());
+    if (blockLength > numSamples)
+        juce::FloatVectorOperations::clear (reinterpret_cast<float*> (data + numSamples),
+                                            (blockLength - numSamples) * IIRfloat_elements);
+}
+
+// one channel for each element of the registers
+void MultiBandCompressorAudioProcessor::addLevels (const int source,
+                                                   const int simdFilterIdx,
+                                                   const IIRfloat& peak,
+                                                   const IIRfloat& sumOfSquares)
+{
+    const float* peakPerChannel = reinterpret_cast<const float*> (&peak);
+    const float* sumOfSquaresPerChannel = reinterpret_cast<const float*> (&sumOfSquares);
+
+    for (int iirElementIdx = 0; iirElementIdx < IIRfloat_elements; ++iirElementIdx)
+        meterTelemetry.addLevels (source,
+                                  simdFilterIdx * IIRfloat_elements + iirElementIdx,
+                                  peakPerChannel[iirElementIdx],
+                                  sumOfSquaresPerChannel[iirElementIdx]);
+}
+
 inline void MultiBandCompressorAudioProcessor::clear (juce::dsp::AudioBlock<IIRfloat>& ab)
 {
     const int N = static_cast<int> (ab.getNumSamples()) * IIRfloat_elements;
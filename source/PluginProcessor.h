@@ -24,9 +24,31 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 
-#include "Analyser.h"
 #include "juce_dsp/juce_dsp.h"
 #include "AudioProcessorBase.h"
+#include "CrossoverCoefficientTable.h"
+#include "FrameScheduler.h"
+#include "LoadMeter.h"
+#include "LoudnessMeter.h"
+#include "MeterTelemetry.h"
+
+// MOSES_HEADLESS builds the processor without an editor, analysers or visualizations
+#ifndef MOSES_HEADLESS
+    #define MOSES_HEADLESS 0
+#endif
+
+#if ! MOSES_HEADLESS
+    #include "Analyser.h"
+#endif
+
+// MOSES_STAGE_PROFILING times every stage of processBlock()
+#ifndef MOSES_STAGE_PROFILING
+    #define MOSES_STAGE_PROFILING 0
+#endif
+
+#if MOSES_STAGE_PROFILING
+    #include "StageProfiler.h"
+#endif
 
 #define ProcessorClass MultiBandCompressorAudioProcessor
 #define numFilterBands 5
@@ -40,6 +62,7 @@ class MultiBandCompressorAudioProcessor
 public:
     constexpr static int numberOfInputChannels = 2;
     constexpr static int numberOfOutputChannels = 2;
+    constexpr static int maxNumChannels = 64;
     //==============================================================================
     MultiBandCompressorAudioProcessor();
     ~MultiBandCompressorAudioProcessor();
@@ -54,9 +77,11 @@ public:
 
     void processBlock (juce::AudioSampleBuffer&, juce::MidiBuffer&) override;
 
+#if ! MOSES_HEADLESS
     void createAnalyserPlot(juce::Path &p, juce::Rectangle<int> bounds, float minFreq, bool input);
 
     bool checkForNewAnalyserData();
+#endif
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -74,7 +99,9 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     //==============================================================================
-    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void sendAdditionalOSCMessages (juce::OSCSender& oscSender,
+                                    const juce::OSCAddressPattern& address) override;
+    const bool processNotYetConsumedOSCMessage (const juce::OSCMessage& message) override;
 
     //======= Parameters ===========================================================
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> createParameterLayout();
@@ -98,43 +125,213 @@ public:
 
     // Interface for gui
     double& getSampleRate() { return lastSampleRate; };
+#if ! MOSES_HEADLESS
     IIR::Coefficients<double>::Ptr lowPassLRCoeffs[numFilterBands - 1];
     IIR::Coefficients<double>::Ptr highPassLRCoeffs[numFilterBands - 1];
+    void updateFilterVisualizationCoefficients();
+
+    // analysers and meters only run while an editor is showing (or, for the loudness, an OSC sender is connected)
+    void setEditorVisible (bool isVisible);
 
+    // set when the sample rate changes, the editor watches the crossovers and gains on its own
     juce::Atomic<bool> repaintFilterVisualization = false;
-    juce::Atomic<float> inputPeak = juce::Decibels::gainToDecibels (-INFINITY),
-                        outputPeak = juce::Decibels::gainToDecibels (-INFINITY);
-    juce::Atomic<float> maxGR[numFilterBands], maxPeak[numFilterBands];
+#endif
+    juce::Atomic<float> maxGR[numFilterBands];
+
+    // peak and RMS of the input, the output and every band, for all channels
+    using Meters = MeterTelemetry<numFilterBands, maxNumChannels>;
+    Meters meterTelemetry;
+
+    // loudness, true peak and crest factor of the same signals, computed by the analysis service
+    LoudnessMeter<IIRfloat, Meters::numSources> loudnessMeter;
 
     juce::Atomic<bool> characteristicHasChanged[numFilterBands];
 
+    // skip the filter stages which only feed killed or un-soloed bands
+    juce::Atomic<bool> lazyBandEvaluation = true;
+
+    // periodic GUI and OSC updates, which give up frames while the audio thread is under load
+    juce::SharedResourcePointer<FrameScheduler> frameScheduler;
+
+    // duration of processBlock() against the real-time budget, and the blocks which overran it
+    LoadMeter loadMeter;
+
+#if MOSES_STAGE_PROFILING
+    // setup, interleave, the filter stages in processing order, summation, metering and deinterleave
+    static constexpr int numProfiledStages = 13;
+    StageProfiler<numProfiledStages> stageProfiler;
+    static juce::String getProfiledStageName (int stage);
+
+    // answers /profile on the message thread, a pending answer is cancelled when the processor goes away
+    struct StageProfileReply : public juce::AsyncUpdater
+    {
+        explicit StageProfileReply (MultiBandCompressorAudioProcessor& p) : processor (p) {}
+        void handleAsyncUpdate() override { processor.sendStageProfile(); }
+        MultiBandCompressorAudioProcessor& processor;
+    };
+    StageProfileReply stageProfileReply { *this };
+#endif
 
     //analysers
+    juce::SharedResourcePointer<AnalysisService> analysisService;
+#if ! MOSES_HEADLESS
     Analyser<float> inputAnalyser;
     Analyser<float> outputAnalyser;
+    Analyser<float> bandAnalyser { numFilterBands }; // one stream for each band, after its gain
+
+    // fft order, hop size and averaging of all analysers, set with /Moses/analyser and kept with the state
+    void setAnalyserSettings (const Analyser<float>::Settings& newSettings);
+    Analyser<float>::Settings getAnalyserSettings() const;
+    int getNumDroppedAnalyserBlocks() const;
+#endif
 
 private:
+    // groups of filters which are processed (or skipped) together, in processing order
+    enum FilterStages
+    {
+        LowPass1,
+        HighPass1,
+        HighPass0,
+        LowPass0,
+        LowPass2,
+        HighPass2,
+        LowPass3,
+        HighPass3,
+        numFilterStages
+    };
+
+#if MOSES_STAGE_PROFILING
+    enum ProfiledStages
+    {
+        setupStage,
+        interleaveStage,
+        firstFilterStage,
+        summationStage = firstFilterStage + numFilterStages,
+        meteringStage, // the part which isn't done during the summation
+        deinterleaveStage
+    };
+    static_assert (deinterleaveStage + 1 == numProfiledStages, "a stage without a name");
+
+    void sendStageProfile();
+#endif
+
+    // indices into the table of parameters read by the audio thread
+    enum DspParameters
+    {
+        firstCrossoverParameter = 0,
+        firstGainParameter = firstCrossoverParameter + numFilterBands - 1,
+        firstSoloParameter = firstGainParameter + numFilterBands,
+        firstKillParameter = firstSoloParameter + numFilterBands,
+        numDspParameters = firstKillParameter + numFilterBands
+    };
+
+    // parameter values used by the audio thread for one block
+    struct ParameterSnapshot
+    {
+        float values[numDspParameters];
+        juce::uint32 dirty; // one bit for each parameter which changed since the last block
+        float bandGains[numFilterBands]; // linear
+        int soloBands;
+        int killedBands;
+    };
+
+    void updateParameterSnapshot();
+    void invalidateParameterSnapshot();
+#if ! MOSES_HEADLESS
+    void updateAnalysers();
+#endif
     void calculateCoefficients (int index);
-    void copyCoeffsToProcessor();
+    void resetFilterStage (int stage);
 
     inline void clear (AudioBlock<IIRfloat>& ab);
+    inline void measureAndClear (AudioBlock<IIRfloat>& ab,
+                                 int numSamples,
+                                 IIRfloat& peak,
+                                 IIRfloat& sumOfSquares);
+    template <bool measureBand, bool measureSum>
+    inline void addBandToSum (const IIRfloat* band,
+                              IIRfloat* sum,
+                              int numSamples,
+                              float gain,
+                              float gainStep,
+                              int numRampSamples,
+                              float endGain,
+                              IIRfloat& peak,
+                              IIRfloat& sumOfSquares,
+                              IIRfloat& sumPeak,
+                              IIRfloat& sumSumOfSquares);
+    void addLevels (int source, int simdFilterIdx, const IIRfloat& peak, const IIRfloat& sumOfSquares);
+#if ! MOSES_HEADLESS
+    void sumBandForAnalyser (int filterBandIdx,
+                             int nSIMDFilters,
+                             int numSamples,
+                             float gain,
+                             float gainStep,
+                             int numRampSamples,
+                             float endGain);
+#endif
+
+#if JUCE_USE_SIMD
+    static inline IIRfloat absMax (IIRfloat a, IIRfloat b)
+    {
+        return IIRfloat::max (a, IIRfloat::abs (b));
+    }
+    static inline float sumOfElements (IIRfloat a) { return a.sum(); }
+#else /* !JUCE_USE_SIMD */
+    static inline IIRfloat absMax (IIRfloat a, IIRfloat b) { return juce::jmax (a, std::abs (b)); }
+    static inline float sumOfElements (IIRfloat a) { return a; }
+#endif
 
     double lastSampleRate { 48000 };
     const int maxNumFilters;
 
     // list of used audio parameters
     std::atomic<float>* orderSetting;
-    std::atomic<float>* crossovers[numFilterBands - 1];
-    std::atomic<float>* gain[numFilterBands];
+    std::atomic<float>* dspParameters[numDspParameters];
+    ParameterSnapshot parameterSnapshot;
+
+    static constexpr int allBandsMask = (1 << numFilterBands) - 1;
+
+    // linear ramp of a band's gain, including its kill and solo state, audio thread only
+    struct BandGainRamp
+    {
+        void rampTo (float newTarget, int numSamples)
+        {
+            target = newTarget;
+            samplesLeft = numSamples;
+            step = (target - gain) / numSamples;
+        }
+
+        float gain = 0.0f;
+        float target = 0.0f;
+        float step = 0.0f;
+        int samplesLeft = 0;
+    };
+
+    BandGainRamp bandGainRamps[numFilterBands];
+    int lastActiveBands = 0;
+    int bandMaskRampLength { 240 };
+    int gainRampLength { 960 };
+
+    // lazy band evaluation
+    static const int stageBandMasks[numFilterStages];
+    bool stageWasProcessed[numFilterStages];
+    int warmUpLength { 960 };
 
-    juce::BigInteger soloArray;
-    juce::BigInteger killArray;
+#if ! MOSES_HEADLESS
+    // demand driven telemetry
+    juce::Atomic<bool> editorIsVisible = false;
+    juce::Atomic<bool> analysersArePrepared = false;
+    juce::AudioBuffer<float> bandAnalyserData;
+
+    juce::SpinLock analyserSettingsLock;
+    Analyser<float>::Settings analyserSettings;
+#endif
 
     // filter coefficients
+    CrossoverCoefficientTable coefficientTable;
     juce::dsp::IIR::Coefficients<float>::Ptr iirLPCoefficients[numFilterBands - 1],
-        iirHPCoefficients[numFilterBands - 1], iirAPCoefficients[numFilterBands - 1],
-        iirTempLPCoefficients[numFilterBands - 1], iirTempHPCoefficients[numFilterBands - 1],
-        iirTempAPCoefficients[numFilterBands - 1];
+        iirHPCoefficients[numFilterBands - 1], iirAPCoefficients[numFilterBands - 1];
 
     // filters (cascaded butterworth/linkwitz-riley filters + allpass)
     juce::OwnedArray<IIR::Filter<IIRfloat>> iirLP[numFilterBands - 1], iirHP[numFilterBands - 1],
@@ -145,7 +342,6 @@ private:
     std::vector<juce::HeapBlock<char>> interleavedBlockData;
     juce::OwnedArray<juce::dsp::AudioBlock<IIRfloat>> interleavedData;
     juce::dsp::AudioBlock<float> zero;
-    juce::AudioBuffer<float> tempBuffer;
 
     // filters for processing
     juce::OwnedArray<juce::dsp::AudioBlock<IIRfloat>> freqBands[numFilterBands];
@@ -156,8 +352,6 @@ private:
     juce::dsp::AudioBlock<float> gains;
     juce::HeapBlock<char> gainData;
 
-    juce::Atomic<bool> userChangedFilterSettings = true;
-
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiBandCompressorAudioProcessor)
 };
@@ -0,0 +1,221 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <chrono>
+
+#if JUCE_INTEL
+    #include <x86intrin.h>
+#endif
+
+/* Time spent in each stage of the audio callback, as histograms over blocks.
+
+ The audio thread marks the end of every stage with lap(), which adds the
+ counter ticks since the previous mark to that stage. endBlock() sorts each
+ stage's ticks into a histogram with four bins per octave, so a stage costs
+ two counter reads and a few additions per block.
+
+ The audio thread is the only writer of the histograms and readers only load
+ them, so a reader may see a block half added. reset() is carried out by the
+ audio thread with its next block.
+
+ The ticks come from the time stamp counter on x86, the virtual counter on
+ arm64 and the monotonic clock elsewhere, all of which run at a constant
+ rate; it is measured against the monotonic clock to convert to seconds. */
+
+template <int numStages>
+class StageProfiler
+{
+public:
+    static constexpr int binsPerOctave = 4;
+    static constexpr int numBins = 32 * binsPerOctave; // up to 2^32 ticks, the first ones hold single tick counts
+
+    struct Statistics
+    {
+        juce::int64 numBlocks = 0; // in which the stage ran
+        double mean = 0.0, p50 = 0.0, p99 = 0.0, max = 0.0; // microseconds per block
+        double share = 0.0; // of the time spent in all stages, 0 to 1
+    };
+
+    StageProfiler()
+    {
+        calibrationStart = { readCounter(), std::chrono::steady_clock::now() };
+        clear();
+    }
+
+    static inline juce::uint64 readCounter() noexcept
+    {
+#if JUCE_INTEL
+        return __rdtsc();
+#elif JUCE_ARM && defined(__aarch64__)
+        juce::uint64 value;
+        asm volatile ("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#else
+        return juce::uint64 (std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    //==============================================================================
+    // audio thread
+
+    void beginBlock() noexcept
+    {
+        if (resetRequested.exchange (false))
+            clear();
+
+        lastTicks = readCounter();
+    }
+
+    /** Adds the ticks since the last mark to a stage. */
+    void lap (const int stage) noexcept
+    {
+        const auto now = readCounter();
+        blockTicks[stage] += now - lastTicks;
+        lastTicks = now;
+    }
+
+    void endBlock() noexcept
+    {
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            const auto ticks = blockTicks[stage];
+            if (ticks == 0)
+                continue;
+
+            blockTicks[stage] = 0;
+
+            auto& bin = bins[stage][getBin (ticks)];
+            bin.store (bin.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            totalTicks[stage].store (totalTicks[stage].load (std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+            if (ticks > maxTicks[stage].load (std::memory_order_relaxed))
+                maxTicks[stage].store (ticks, std::memory_order_relaxed);
+            numBlocks[stage].store (numBlocks[stage].load (std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    }
+
+    //==============================================================================
+    // any other thread
+
+    /** Forgets all blocks so far, with the next block. */
+    void reset() noexcept { resetRequested = true; }
+
+    Statistics getStatistics (const int stage) const
+    {
+        Statistics statistics;
+        const auto count = numBlocks[stage].load (std::memory_order_acquire);
+        if (count == 0)
+            return statistics;
+
+        juce::uint64 allTicks = 0;
+        for (int i = 0; i < numStages; ++i)
+            allTicks += totalTicks[i].load (std::memory_order_relaxed);
+
+        const double microsecondsPerTick = 1.0e6 / getTicksPerSecond();
+        const auto ticks = totalTicks[stage].load (std::memory_order_relaxed);
+
+        statistics.numBlocks = count;
+        statistics.mean = microsecondsPerTick * double (ticks) / double (count);
+        statistics.p50 = microsecondsPerTick * getPercentile (stage, 0.5);
+        statistics.p99 = microsecondsPerTick * getPercentile (stage, 0.99);
+        statistics.max = microsecondsPerTick * double (maxTicks[stage].load (std::memory_order_relaxed));
+        statistics.share = allTicks > 0 ? double (ticks) / double (allTicks) : 0.0;
+        return statistics;
+    }
+
+    /** The counter's rate, measured against the monotonic clock since construction. */
+    double getTicksPerSecond() const
+    {
+        const auto ticks = readCounter() - calibrationStart.first;
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - calibrationStart.second;
+        return elapsed.count() > 0.0 && ticks > 0 ? double (ticks) / elapsed.count() : 1.0e9;
+    }
+
+private:
+    static int getBin (const juce::uint64 ticks) noexcept
+    {
+        if (ticks < 2 * binsPerOctave)
+            return int (ticks);
+
+        const auto clipped = juce::uint32 (juce::jmin (ticks, juce::uint64 (0xffffffff)));
+        const int octave = juce::findHighestSetBit (clipped);
+        const int step = int ((clipped >> (octave - 2)) & (binsPerOctave - 1));
+        return juce::jmin (numBins - 1, binsPerOctave * octave + step);
+    }
+
+    // the middle of a bin, in ticks
+    static double getBinValue (const int bin) noexcept
+    {
+        if (bin < 2 * binsPerOctave)
+            return double (bin);
+
+        const int octave = bin / binsPerOctave;
+        return std::ldexp (binsPerOctave + bin % binsPerOctave + 0.5, octave - 2);
+    }
+
+    double getPercentile (const int stage, const double fraction) const noexcept
+    {
+        juce::uint64 count = 0;
+        for (int bin = 0; bin < numBins; ++bin)
+            count += bins[stage][bin].load (std::memory_order_relaxed);
+
+        const auto rank = juce::uint64 (fraction * double (count));
+        juce::uint64 below = 0;
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            below += bins[stage][bin].load (std::memory_order_relaxed);
+            if (below > rank)
+                return getBinValue (bin);
+        }
+
+        return 0.0;
+    }
+
+    void clear() noexcept
+    {
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            for (auto& bin : bins[stage])
+                bin.store (0, std::memory_order_relaxed);
+            totalTicks[stage].store (0, std::memory_order_relaxed);
+            maxTicks[stage].store (0, std::memory_order_relaxed);
+            numBlocks[stage].store (0, std::memory_order_release);
+            blockTicks[stage] = 0;
+        }
+    }
+
+    // audio thread only
+    juce::uint64 lastTicks = 0;
+    juce::uint64 blockTicks[size_t (numStages)];
+
+    // written by the audio thread only
+    std::atomic<juce::uint32> bins[size_t (numStages)][size_t (numBins)];
+    std::atomic<juce::uint64> totalTicks[size_t (numStages)];
+    std::atomic<juce::uint64> maxTicks[size_t (numStages)];
+    std::atomic<juce::int64> numBlocks[size_t (numStages)];
+
+    std::atomic<bool> resetRequested { false };
+    std::pair<juce::uint64, std::chrono::steady_clock::time_point> calibrationStart;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageProfiler)
+};
@@ -0,0 +1,125 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+/* Scrolling spectrogram, time from left to right and frequency from bottom to top.
+
+ Each new spectrum is written as one pixel column into an image used as a
+ ring, its levels mapped to colours through a lookup table. Painting draws
+ the two parts of the ring next to each other, so a frame costs the same
+ no matter how much history is shown. */
+
+class WaterfallDisplay : public juce::Component
+{
+public:
+    static constexpr int colourMapSize = 256;
+
+    WaterfallDisplay()
+    {
+        setOpaque (true);
+        setInterceptsMouseClicks (false, false);
+        setLevelRange (-80.0f, 0.0f);
+    }
+
+    /** Levels mapped to the first and the last colour of the colour map, in dB. */
+    void setLevelRange (const float minDb, const float maxDb)
+    {
+        minLevel = minDb;
+        levelToIndex = (colourMapSize - 1) / juce::jmax (1.0f, maxDb - minDb);
+
+        // dark blue over purple and red to yellow
+        juce::ColourGradient gradient (juce::Colour (0xFF0B0B1A), 0.0f, 0.0f, juce::Colour (0xFFFFF3A0), 1.0f, 0.0f, false);
+        gradient.addColour (0.3, juce::Colour (0xFF3B1F7A));
+        gradient.addColour (0.6, juce::Colour (0xFFC4384A));
+        gradient.addColour (0.85, juce::Colour (0xFFF5A623));
+
+        for (int i = 0; i < colourMapSize; ++i)
+            colourMap[i] = gradient.getColourAtPosition (double (i) / (colourMapSize - 1)).getPixelARGB();
+    }
+
+    /** Number of levels a column consists of, one per pixel row. */
+    int getNumRows() const noexcept { return image.getHeight(); }
+
+    /** Calls fillLevels (float* levels, int numRows) for the levels of the new column in dB,
+        lowest frequency first, which returns false if there is nothing to add. Returns true,
+        if the display has scrolled. */
+    template <typename FillLevels>
+    bool addColumn (FillLevels&& fillLevels)
+    {
+        const int numRows = image.getHeight();
+        if (numRows == 0 || ! fillLevels (levels.data(), numRows))
+            return false;
+
+        {
+            juce::Image::BitmapData pixels (image, writeColumn, 0, 1, numRows, juce::Image::BitmapData::writeOnly);
+            for (int row = 0; row < numRows; ++row)
+            {
+                const int index = juce::jlimit (0, colourMapSize - 1, int ((levels[size_t (row)] - minLevel) * levelToIndex));
+                reinterpret_cast<juce::PixelRGB*> (pixels.getPixelPointer (0, numRows - 1 - row))->set (colourMap[index]);
+            }
+        }
+
+        if (++writeColumn == image.getWidth())
+            writeColumn = 0;
+
+        repaint();
+        return true;
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        const int width = image.getWidth();
+        const int height = image.getHeight();
+        if (width == 0)
+            return;
+
+        // oldest column first: the part from the write position to the end, then the beginning
+        const int numOldest = width - writeColumn;
+        g.drawImage (image, 0, 0, numOldest, height, writeColumn, 0, numOldest, height);
+        if (writeColumn > 0)
+            g.drawImage (image, numOldest, 0, writeColumn, height, 0, 0, writeColumn, height);
+    }
+
+    void resized() override
+    {
+        const int width = juce::jmax (1, getWidth());
+        const int height = juce::jmax (1, getHeight());
+
+        image = juce::Image (juce::Image::RGB, width, height, false);
+        image.clear (image.getBounds(), juce::Colour (colourMap[0]));
+        levels.resize (size_t (height));
+        writeColumn = 0;
+    }
+
+private:
+    juce::Image image;
+    int writeColumn = 0; // next column to be written, the oldest one
+
+    std::vector<float> levels;
+
+    juce::PixelARGB colourMap[colourMapSize];
+    float minLevel = -80.0f;
+    float levelToIndex = 1.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaterfallDisplay)
+};
@@ -0,0 +1,284 @@
+/*
+ ==============================================================================
+ This file is part of Moses, which is based on the IEM plug-in suite.
+ https://iem.at
+
+ Moses is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Moses is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this software.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_graphics/juce_graphics.h>
+
+/* Min/max history of a multichannel signal for waveform views.
+
+ Level 0 holds the minimum and maximum over all channels of every
+ baseBucketSize samples, each further level merges levelFactor buckets of
+ the level below. Every level is a ring of the most recent buckets, so a view
+ picks the level closest to its zoom and never touches the audio itself.
+
+ The audio thread writes, the message thread reads without locks: a reader
+ only keeps the buckets which can't have been overwritten while it copied.
+ Views register with addReader() while they are showing, the audio thread
+ only feeds the pyramid while hasReaders() is true. The first reader starts
+ a new history, so nothing from before the gap gets joined onto it. */
+
+class WaveformPyramid
+{
+public:
+    static constexpr int baseBucketSize = 16;
+    static constexpr int levelFactor = 4;
+    static constexpr int numLevels = 6; // 16 up to 16384 samples per bucket
+    static constexpr int ringSize = 8192; // buckets per level, a power of two
+
+    struct MinMax
+    {
+        float min = std::numeric_limits<float>::max();
+        float max = std::numeric_limits<float>::lowest();
+
+        void add (const MinMax& other) noexcept
+        {
+            min = juce::jmin (min, other.min);
+            max = juce::jmax (max, other.max);
+        }
+
+        bool isEmpty() const noexcept { return min > max; }
+    };
+
+    WaveformPyramid() :
+        rings (size_t (numLevels * ringSize)),
+        scratch (size_t (ringSize))
+    {
+    }
+
+    static constexpr int getBucketSize (const int level) noexcept
+    {
+        return level == 0 ? baseBucketSize : levelFactor * getBucketSize (level - 1);
+    }
+
+    /** Forgets the history, must not be called while the audio thread is writing. */
+    void prepare (const double sampleRateToUse, const int maximumBlockSize)
+    {
+        sampleRate = sampleRateToUse;
+        blockMin.resize (size_t (juce::jmax (baseBucketSize, maximumBlockSize)));
+        blockMax.resize (blockMin.size());
+
+        for (auto& count : numWritten)
+            count = 0;
+        for (auto& first : historyStart)
+            first = 0;
+        restartHistory();
+    }
+
+    void addReader() noexcept
+    {
+        if (numReaders++ == 0)
+            restartRequested = true;
+    }
+
+    void removeReader() noexcept { --numReaders; }
+    bool hasReaders() const noexcept { return numReaders.load (std::memory_order_relaxed) > 0; }
+
+    //==============================================================================
+    // audio thread
+
+    void addAudioData (const juce::AudioBuffer<float>& buffer, const int numChannels) noexcept
+    {
+        if (restartRequested.exchange (false))
+        {
+            restartHistory();
+            for (int level = 0; level < numLevels; ++level)
+                historyStart[level].store (numWritten[level].load (std::memory_order_relaxed), std::memory_order_release);
+        }
+
+        const int numSamples = buffer.getNumSamples();
+        const int channels = juce::jmin (numChannels, buffer.getNumChannels());
+        const int maxChunkSize = static_cast<int> (blockMin.size());
+        if (channels < 1 || maxChunkSize < 1)
+            return;
+
+        using FVO = juce::FloatVectorOperations;
+
+        for (int start = 0; start < numSamples; start += maxChunkSize)
+        {
+            const int chunkSize = juce::jmin (maxChunkSize, numSamples - start);
+
+            // lane-wise minimum and maximum over all channels, one pass over the block per channel
+            FVO::copy (blockMin.data(), buffer.getReadPointer (0, start), chunkSize);
+            FVO::copy (blockMax.data(), buffer.getReadPointer (0, start), chunkSize);
+            for (int channel = 1; channel < channels; ++channel)
+            {
+                FVO::min (blockMin.data(), blockMin.data(), buffer.getReadPointer (channel, start), chunkSize);
+                FVO::max (blockMax.data(), blockMax.data(), buffer.getReadPointer (channel, start), chunkSize);
+            }
+
+            for (int i = 0; i < chunkSize;)
+            {
+                const int n = juce::jmin (chunkSize - i, baseBucketSize - baseFill);
+                pending[0].add ({ FVO::findMinimum (blockMin.data() + i, n), FVO::findMaximum (blockMax.data() + i, n) });
+
+                i += n;
+                baseFill += n;
+                if (baseFill == baseBucketSize)
+                {
+                    baseFill = 0;
+                    pushBucket (0);
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    // message thread
+
+    /** The coarsest level which still has at least one bucket per pixel. */
+    static int getLevelForSamplesPerPixel (const double samplesPerPixel) noexcept
+    {
+        int level = 0;
+        while (level + 1 < numLevels && getBucketSize (level + 1) <= samplesPerPixel)
+            ++level;
+        return level;
+    }
+
+    /** Copies the most recent buckets of a level, oldest first, and returns how many it copied. */
+    int readLatest (const int level, MinMax* destination, const int numBuckets) const noexcept
+    {
+        const auto* ring = rings.data() + level * ringSize;
+
+        const auto end = numWritten[level].load (std::memory_order_acquire);
+        const auto first = juce::jmin (end, historyStart[level].load (std::memory_order_acquire));
+        const auto start = juce::jmax (first, end - juce::jmin (numBuckets, ringSize));
+        for (auto index = start; index < end; ++index)
+            destination[index - start] = ring[index & (ringSize - 1)];
+
+        // the writer may have overwritten the oldest buckets in the meantime, and is working on the slot after the last one
+        const auto firstValid = numWritten[level].load (std::memory_order_acquire) - ringSize + 1;
+        if (firstValid > start)
+        {
+            const auto numInvalid = int (juce::jmin (firstValid, end) - start);
+            std::copy (destination + numInvalid, destination + (end - start), destination);
+            return int (end - start) - numInvalid;
+        }
+
+        return int (end - start);
+    }
+
+    /** A filled min/max outline of the last secondsVisible, the newest samples at the right. */
+    void createPath (juce::Path& p, const juce::Rectangle<float> bounds, const double secondsVisible)
+    {
+        p.clear();
+
+        const int width = static_cast<int> (bounds.getWidth());
+        if (width < 1 || secondsVisible <= 0.0)
+            return;
+
+        const double samplesVisible = secondsVisible * sampleRate;
+        const int level = getLevelForSamplesPerPixel (samplesVisible / width);
+        const int numBuckets = juce::jlimit (1, ringSize, juce::roundToInt (samplesVisible / getBucketSize (level)));
+        const int numRead = readLatest (level, scratch.data(), numBuckets);
+        if (numRead < 1)
+            return;
+
+        // buckets which aren't there yet are missing at the left
+        const int missing = numBuckets - numRead;
+        const double bucketsPerPixel = double (numBuckets) / width;
+        const float yScale = -0.5f * bounds.getHeight();
+        const float yCentre = bounds.getCentreY();
+
+        auto toY = [&] (const float value) { return yCentre + yScale * juce::jlimit (-1.0f, 1.0f, value); };
+
+        columns.resize (size_t (width));
+        int firstColumn = -1;
+        for (int x = 0; x < width; ++x)
+        {
+            const int from = juce::jmax (0, int (x * bucketsPerPixel) - missing);
+            const int to = juce::jmin (numRead, int ((x + 1) * bucketsPerPixel) - missing);
+
+            // at least one bucket per column, once the history has started
+            MinMax column;
+            if (to > 0)
+                for (int bucket = from; bucket < juce::jmax (to, from + 1); ++bucket)
+                    column.add (scratch[size_t (bucket)]);
+
+            columns[size_t (x)] = column;
+            if (firstColumn < 0 && ! column.isEmpty())
+                firstColumn = x;
+        }
+
+        if (firstColumn < 0)
+            return;
+
+        p.preallocateSpace (6 * (width - firstColumn) + 3);
+        p.startNewSubPath (bounds.getX() + firstColumn, toY (columns[size_t (firstColumn)].max));
+        for (int x = firstColumn + 1; x < width; ++x)
+            p.lineTo (bounds.getX() + x, toY (columns[size_t (x)].max));
+        for (int x = width; --x >= firstColumn;)
+            p.lineTo (bounds.getX() + x, toY (columns[size_t (x)].min));
+        p.closeSubPath();
+    }
+
+    double getSampleRate() const noexcept { return sampleRate; }
+
+private:
+    // drops the buckets being merged, the history before them stays in the rings
+    void restartHistory() noexcept
+    {
+        for (auto& merged : pending)
+            merged = {};
+        for (auto& count : pendingCount)
+            count = 0;
+        baseFill = 0;
+    }
+
+    void pushBucket (const int level) noexcept
+    {
+        const auto index = numWritten[level].load (std::memory_order_relaxed);
+        rings[size_t (level * ringSize + (index & (ringSize - 1)))] = pending[level];
+        numWritten[level].store (index + 1, std::memory_order_release);
+
+        if (level + 1 < numLevels)
+        {
+            pending[level + 1].add (pending[level]);
+            if (++pendingCount[level + 1] == levelFactor)
+            {
+                pendingCount[level + 1] = 0;
+                pushBucket (level + 1);
+            }
+        }
+
+        pending[level] = {};
+    }
+
+    double sampleRate = 48000.0;
+
+    std::vector<MinMax> rings; // ringSize buckets for each level
+    std::atomic<juce::int64> numWritten[numLevels] {};
+    std::atomic<juce::int64> historyStart[numLevels] {}; // the first bucket of the current history
+    std::atomic<int> numReaders { 0 };
+    std::atomic<bool> restartRequested { false };
+
+    // audio thread only, the bucket each level is working on
+    MinMax pending[numLevels];
+    int pendingCount[numLevels] = {}; // buckets of the level below merged into it
+    int baseFill = 0; // samples in the level 0 bucket
+    std::vector<float> blockMin, blockMax; // over all channels, for each sample of a block
+
+    // message thread only
+    std::vector<MinMax> scratch;
+    std::vector<MinMax> columns;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformPyramid)
+};